@@ -0,0 +1,115 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/**
+ * Allocates a block with room for at least the given number of bytes.
+ * @param size
+ * @param next Block to link after the new one.
+ * @return The new block.
+ */
+static ArenaBlock *arenaBlockNew(size_t size, ArenaBlock *next) {
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+    assert(block != NULL);
+    block->next = next;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/**
+ * Returns the offset of the first suitably aligned free byte in the block.
+ * @param block
+ * @param alignment
+ * @return Offset into the block's data.
+ */
+static size_t alignedOffset(ArenaBlock *block, size_t alignment) {
+    uintptr_t start = (uintptr_t) (block->data + block->used);
+    uintptr_t aligned = (start + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    return block->used + (size_t) (aligned - start);
+}
+
+/**
+ * Creates an empty arena. No block is allocated until the first allocation.
+ * @param blockSize Size of each block. Larger allocations get their own block.
+ * @return The allocated arena.
+ */
+Arena *arenaNew(size_t blockSize) {
+    assert(blockSize > 0);
+    Arena *arena = malloc(sizeof(Arena));
+    arena->head = NULL;
+    arena->blockSize = blockSize;
+    arena->allocated = 0;
+    return arena;
+}
+
+/**
+ * Frees every block and the arena itself, invalidating everything allocated
+ * from it.
+ * @param arena
+ */
+void arenaDelete(Arena *arena) {
+    assert(arena != NULL);
+    ArenaBlock *block = arena->head;
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+/**
+ * Allocates memory from the arena. The memory is not initialized and stays
+ * valid until the arena is deleted.
+ * @param arena
+ * @param size Number of bytes.
+ * @param alignment Power of two the address must be a multiple of.
+ * @return Pointer to the memory.
+ */
+void *arenaAlloc(Arena *arena, size_t size, size_t alignment) {
+    assert(arena != NULL);
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    ArenaBlock *block = arena->head;
+    if (block != NULL) {
+        size_t offset = alignedOffset(block, alignment);
+        if (offset + size <= block->size) {
+            block->used = offset + size;
+            arena->allocated += size;
+            return block->data + offset;
+        }
+    }
+
+    // Start a new block, padded so the alignment can always be met
+    size_t blockSize = arena->blockSize;
+    if (size + alignment > blockSize) {
+        blockSize = size + alignment;
+    }
+    block = arenaBlockNew(blockSize, arena->head);
+    arena->head = block;
+    size_t offset = alignedOffset(block, alignment);
+    block->used = offset + size;
+    arena->allocated += size;
+    return block->data + offset;
+}
+
+/**
+ * Copies a null terminated string into the arena.
+ * @param arena
+ * @param string
+ * @return The copy.
+ */
+char *arenaStrdup(Arena *arena, const char *string) {
+    size_t length = strlen(string) + 1;
+    char *copy = arenaAlloc(arena, length, 1);
+    memcpy(copy, string, length);
+    return copy;
+}
@@ -0,0 +1,42 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <stddef.h>
+
+/*
+ * Bump allocator. Memory is handed out from large blocks and is only returned
+ * all at once by arenaDelete, so allocation is a pointer bump and teardown is
+ * one free per block.
+ */
+
+typedef struct Arena Arena;
+typedef struct ArenaBlock ArenaBlock;
+
+struct ArenaBlock
+{
+    ArenaBlock* next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct Arena
+{
+    // Block currently being allocated from, linked to the older blocks.
+    ArenaBlock* head;
+    size_t blockSize;
+    // Total bytes handed out.
+    size_t allocated;
+};
+
+Arena* arenaNew(size_t blockSize);
+void arenaDelete(Arena* arena);
+void* arenaAlloc(Arena* arena, size_t size, size_t alignment);
+char* arenaStrdup(Arena* arena, const char* string);
+
+#endif
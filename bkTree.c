@@ -0,0 +1,178 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "bkTree.h"
+#include "levenshtein.h"
+#include <stdlib.h>
+#include <assert.h>
+
+/**
+ * Creates an empty tree.
+ * @return The allocated tree.
+ */
+BkTree *bkTreeNew(void) {
+    BkTree *tree = malloc(sizeof(BkTree));
+    tree->size = 0;
+    tree->capacity = 1024;
+    tree->nodes = malloc(sizeof(BkNode) * tree->capacity);
+    tree->stopDistance = -1;
+    tree->stopFrequency = 0;
+    return tree;
+}
+
+/**
+ * Frees the tree. The words are not freed.
+ * @param tree
+ */
+void bkTreeDelete(BkTree *tree) {
+    assert(tree != NULL);
+    free(tree->nodes);
+    free(tree);
+}
+
+/**
+ * Appends a node with no children.
+ * @param tree
+ * @param word
+ * @param distance Distance from the parent's word.
+ * @param frequency
+ * @return Index of the node.
+ */
+static int bkNodeNew(BkTree *tree, const char *word, int distance, int frequency) {
+    if (tree->size == tree->capacity) {
+        tree->capacity *= 2;
+        tree->nodes = realloc(tree->nodes, sizeof(BkNode) * tree->capacity);
+    }
+    BkNode *node = &tree->nodes[tree->size];
+    node->word = word;
+    node->distance = distance;
+    node->frequency = frequency;
+    node->maxChildDistance = -1;
+    node->firstChild = -1;
+    node->nextSibling = -1;
+    return tree->size++;
+}
+
+/**
+ * Adds a word to the tree, which keeps a pointer to it. Adding a word that is
+ * already in the tree does nothing.
+ * @param tree
+ * @param word
+ * @param frequency How common the word is; higher ranks first among words
+ * at the same distance.
+ */
+void bkTreeAdd(BkTree *tree, const char *word, int frequency) {
+    assert(tree != NULL);
+    assert(word != NULL);
+    if (tree->size == 0) {
+        bkNodeNew(tree, word, 0, frequency);
+        return;
+    }
+    int current = 0;
+    while (1) {
+        int distance = levenshteinBounded(word, tree->nodes[current].word, LEVENSHTEIN_UNBOUNDED);
+        if (distance == 0) {
+            return;
+        }
+        // Follow the child filed under the same distance, if there is one
+        int child = tree->nodes[current].firstChild;
+        while (child >= 0 && tree->nodes[child].distance != distance) {
+            child = tree->nodes[child].nextSibling;
+        }
+        if (child < 0) {
+            int node = bkNodeNew(tree, word, distance, frequency);
+            tree->nodes[node].nextSibling = tree->nodes[current].firstChild;
+            tree->nodes[current].firstChild = node;
+            if (distance > tree->nodes[current].maxChildDistance) {
+                tree->nodes[current].maxChildDistance = distance;
+            }
+            return;
+        }
+        current = child;
+    }
+}
+
+/**
+ * Makes searches stop as soon as they have found numSuggestions words, each
+ * within stopDistance of the query and with a frequency of at least
+ * stopFrequency (see topKSetStop).
+ * @param tree
+ * @param stopDistance -1 to always search the whole tree.
+ * @param stopFrequency
+ */
+void bkTreeSetEarlyStop(BkTree *tree, int stopDistance, int stopFrequency) {
+    assert(tree != NULL);
+    tree->stopDistance = stopDistance;
+    tree->stopFrequency = stopFrequency;
+}
+
+/**
+ * Finds the words closest to the query. The search radius starts unbounded
+ * and shrinks to just under the farthest suggestion once the array is full,
+ * so only subtrees that could hold a closer word are visited. Distances are
+ * bounded by the radius plus the node's largest child distance: a node
+ * farther away than that can neither be suggested nor have a child in range.
+ * With an early stop set, the search also ends once the suggestions are good
+ * enough.
+ *
+ * The tree is always arranged by Levenshtein distance. For other metrics the
+ * walk uses the Levenshtein radius that holds every word within the
+ * suggestion radius, and the words inside it are measured again with the
+ * metric.
+ * @param tree
+ * @param query
+ * @param suggestions Filled with the closest words, nearest first.
+ * @param numSuggestions Number of words wanted.
+ * @param metric Distance to rank the words by, one of the METRIC_ constants.
+ * @return Number of suggestions found, less than numSuggestions only if the
+ * tree has fewer words.
+ */
+int bkTreeSearch(BkTree *tree, const char *query, Suggestion *suggestions, int numSuggestions,
+                 int metric) {
+    assert(tree != NULL);
+    assert(query != NULL);
+    assert(numSuggestions > 0);
+    if (tree->size == 0) {
+        return 0;
+    }
+
+    TopK topK;
+    topKInit(&topK, suggestions, numSuggestions);
+    topKSetStop(&topK, tree->stopDistance, tree->stopFrequency);
+    int *stack = malloc(sizeof(int) * tree->size);
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0 && !topKDone(&topK)) {
+        BkNode *node = &tree->nodes[stack[--top]];
+        int radius = editDistanceLevenshteinRadius(metric, topKBound(&topK));
+        int bound = radius + (node->maxChildDistance > 0 ? node->maxChildDistance : 0);
+        if (bound > LEVENSHTEIN_UNBOUNDED) {
+            bound = LEVENSHTEIN_UNBOUNDED;
+        }
+        int distance = levenshteinBounded(query, node->word, bound);
+        if (distance > bound) {
+            continue;
+        }
+        if (metric == METRIC_LEVENSHTEIN) {
+            topKOffer(&topK, node->word, distance, node->frequency);
+        } else if (distance <= radius) {
+            int metricBound = topKBound(&topK);
+            int metricDistance = editDistanceBounded(metric, query, node->word, metricBound);
+            if (metricDistance <= metricBound) {
+                topKOffer(&topK, node->word, metricDistance, node->frequency);
+            }
+        }
+
+        radius = editDistanceLevenshteinRadius(metric, topKBound(&topK));
+        for (int child = node->firstChild; child >= 0; child = tree->nodes[child].nextSibling) {
+            int edge = tree->nodes[child].distance;
+            if (edge >= distance - radius && edge <= distance + radius) {
+                stack[top++] = child;
+            }
+        }
+    }
+    free(stack);
+    return topKFinish(&topK);
+}
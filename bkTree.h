@@ -0,0 +1,55 @@
+#ifndef BK_TREE_H
+#define BK_TREE_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "suggestion.h"
+
+/*
+ * Burkhard-Keller tree over Levenshtein distance. Every child of a node is
+ * filed under its distance to the node, so by the triangle inequality a
+ * search for words within distance r of a query that is d away from a node
+ * only needs to visit the children filed under d - r through d + r.
+ */
+
+typedef struct BkNode BkNode;
+typedef struct BkTree BkTree;
+
+struct BkNode
+{
+    // Word stored at the node, not owned by the tree.
+    const char* word;
+    // Distance from the parent's word.
+    int distance;
+    // How common the word is, used to rank words at equal distance.
+    int frequency;
+    // Largest distance any child is filed under, -1 without children.
+    int maxChildDistance;
+    // Index of the first child and of the next child of the same parent, or
+    // -1 for none.
+    int firstChild;
+    int nextSibling;
+};
+
+struct BkTree
+{
+    // Nodes in insertion order, the root first.
+    BkNode* nodes;
+    int size;
+    int capacity;
+    // Searches stop early as set by bkTreeSetEarlyStop, never by default.
+    int stopDistance;
+    int stopFrequency;
+};
+
+BkTree* bkTreeNew(void);
+void bkTreeDelete(BkTree* tree);
+void bkTreeAdd(BkTree* tree, const char* word, int frequency);
+void bkTreeSetEarlyStop(BkTree* tree, int stopDistance, int stopFrequency);
+int bkTreeSearch(BkTree* tree, const char* query, Suggestion* suggestions, int numSuggestions,
+                 int metric);
+
+#endif
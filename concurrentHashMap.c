@@ -0,0 +1,173 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "concurrentHashMap.h"
+#include <stdlib.h>
+#include <assert.h>
+
+/**
+ * Returns the segment that holds the given key.
+ * @param map
+ * @param key
+ * @return The segment.
+ */
+static MapSegment *keySegment(ConcurrentHashMap *map, const char *key) {
+    // The segment maps index buckets with the low bits of the same hash
+    unsigned int hash = map->hashFunction(key, map->hashSeed);
+    return &map->segments[hash >> (32 - CONCURRENT_SEGMENT_BITS)];
+}
+
+/**
+ * Creates an empty map.
+ * @param capacity Total number of buckets to start with, spread over the
+ * segments.
+ * @return The allocated map.
+ */
+ConcurrentHashMap *concurrentHashMapNew(int capacity) {
+    ConcurrentHashMap *map = malloc(sizeof(ConcurrentHashMap));
+    map->hashFunction = DEFAULT_HASH_FUNCTION;
+    map->hashSeed = hashRandomSeed();
+    int segmentCapacity = capacity / CONCURRENT_SEGMENTS > 0 ? capacity / CONCURRENT_SEGMENTS : 1;
+    for (int i = 0; i < CONCURRENT_SEGMENTS; i++) {
+        pthread_mutex_init(&map->segments[i].lock, NULL);
+        map->segments[i].map = hashMapNew(segmentCapacity);
+        hashMapSetHashFunction(map->segments[i].map, map->hashFunction, map->hashSeed);
+        hashMapUseArena(map->segments[i].map);
+    }
+    return map;
+}
+
+/**
+ * Frees the map. No other thread may be using it.
+ * @param map
+ */
+void concurrentHashMapDelete(ConcurrentHashMap *map) {
+    assert(map != NULL);
+    for (int i = 0; i < CONCURRENT_SEGMENTS; i++) {
+        hashMapDelete(map->segments[i].map);
+        pthread_mutex_destroy(&map->segments[i].lock);
+    }
+    free(map);
+}
+
+/**
+ * Looks up the value of a key. The value is copied out, since a pointer into
+ * the map could be invalidated by another thread at any time.
+ * @param map
+ * @param key
+ * @param value Set to the value if the key is found.
+ * @return 1 if the key is found, 0 otherwise.
+ */
+int concurrentHashMapGet(ConcurrentHashMap *map, const char *key, int *value) {
+    assert(map != NULL);
+    assert(key != NULL);
+    MapSegment *segment = keySegment(map, key);
+    pthread_mutex_lock(&segment->lock);
+    int *found = hashMapGet(segment->map, key);
+    if (found != NULL) {
+        *value = *found;
+    }
+    pthread_mutex_unlock(&segment->lock);
+    return found != NULL;
+}
+
+/**
+ * Sets the value of a key, adding the key if it is not in the map.
+ * @param map
+ * @param key
+ * @param value
+ */
+void concurrentHashMapPut(ConcurrentHashMap *map, const char *key, int value) {
+    assert(map != NULL);
+    assert(key != NULL);
+    MapSegment *segment = keySegment(map, key);
+    pthread_mutex_lock(&segment->lock);
+    hashMapPut(segment->map, key, value);
+    pthread_mutex_unlock(&segment->lock);
+}
+
+/**
+ * Atomically adds to the value of a key, inserting the key with the delta as
+ * its value if it is not in the map. Counting words from many threads is one
+ * call per word.
+ * @param map
+ * @param key
+ * @param delta
+ * @return The new value.
+ */
+int concurrentHashMapAdd(ConcurrentHashMap *map, const char *key, int delta) {
+    assert(map != NULL);
+    assert(key != NULL);
+    MapSegment *segment = keySegment(map, key);
+    pthread_mutex_lock(&segment->lock);
+    int result = *hashMapGetOrInsert(segment->map, key, 0) += delta;
+    pthread_mutex_unlock(&segment->lock);
+    return result;
+}
+
+/**
+ * Removes a key. Does nothing if the key is not in the map.
+ * @param map
+ * @param key
+ */
+void concurrentHashMapRemove(ConcurrentHashMap *map, const char *key) {
+    assert(map != NULL);
+    assert(key != NULL);
+    MapSegment *segment = keySegment(map, key);
+    pthread_mutex_lock(&segment->lock);
+    hashMapRemove(segment->map, key);
+    pthread_mutex_unlock(&segment->lock);
+}
+
+/**
+ * Returns the number of keys. With other threads writing, the count is only
+ * a snapshot of each segment at a slightly different moment.
+ * @param map
+ * @return Number of keys.
+ */
+int concurrentHashMapSize(ConcurrentHashMap *map) {
+    assert(map != NULL);
+    int size = 0;
+    for (int i = 0; i < CONCURRENT_SEGMENTS; i++) {
+        pthread_mutex_lock(&map->segments[i].lock);
+        size += hashMapSize(map->segments[i].map);
+        pthread_mutex_unlock(&map->segments[i].lock);
+    }
+    return size;
+}
+
+/**
+ * Starts an iteration over every key in the map. No thread may write to the
+ * map until the iteration is over.
+ * @param iterator
+ * @param map
+ */
+void concurrentHashMapIteratorInit(ConcurrentHashMapIterator *iterator, ConcurrentHashMap *map) {
+    assert(map != NULL);
+    iterator->map = map;
+    iterator->segment = 0;
+    hashMapIteratorInit(&iterator->mapIterator, map->segments[0].map);
+}
+
+/**
+ * Advances the iterator to the next key.
+ * @param iterator
+ * @param key Set to the key.
+ * @param value Set to the key's value.
+ * @return 1 if a key was found, 0 once every key has been visited.
+ */
+int concurrentHashMapIteratorNext(ConcurrentHashMapIterator *iterator, const char **key,
+                                  int *value) {
+    int *found;
+    while (!hashMapIteratorNext(&iterator->mapIterator, key, &found)) {
+        if (++iterator->segment == CONCURRENT_SEGMENTS) {
+            iterator->segment--;
+            return 0;
+        }
+        hashMapIteratorInit(&iterator->mapIterator, iterator->map->segments[iterator->segment].map);
+    }
+    *value = *found;
+    return 1;
+}
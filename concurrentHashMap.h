@@ -0,0 +1,63 @@
+#ifndef CONCURRENT_HASH_MAP_H
+#define CONCURRENT_HASH_MAP_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <pthread.h>
+#include "hashMap.h"
+
+/*
+ * Thread-safe map from strings to ints, striped into segments. Each segment
+ * is an ordinary arena-backed HashMap guarded by its own lock, and the top
+ * bits of a key's hash pick the segment. Threads working on different
+ * segments never wait for each other, and a segment that outgrows its table
+ * resizes while holding only its own lock, so the rest of the map stays
+ * available for the whole resize.
+ */
+
+// Number of segments, a power of two.
+#define CONCURRENT_SEGMENTS 64
+#define CONCURRENT_SEGMENT_BITS 6
+
+typedef struct ConcurrentHashMap ConcurrentHashMap;
+typedef struct MapSegment MapSegment;
+typedef struct ConcurrentHashMapIterator ConcurrentHashMapIterator;
+
+struct MapSegment
+{
+    pthread_mutex_t lock;
+    HashMap* map;
+    // Keeps neighbouring segments' locks off the same cache line.
+    char padding[64];
+};
+
+struct ConcurrentHashMap
+{
+    MapSegment segments[CONCURRENT_SEGMENTS];
+    HashFunction hashFunction;
+    unsigned int hashSeed;
+};
+
+struct ConcurrentHashMapIterator
+{
+    ConcurrentHashMap* map;
+    int segment;
+    HashMapIterator mapIterator;
+};
+
+ConcurrentHashMap* concurrentHashMapNew(int capacity);
+void concurrentHashMapDelete(ConcurrentHashMap* map);
+int concurrentHashMapGet(ConcurrentHashMap* map, const char* key, int* value);
+void concurrentHashMapPut(ConcurrentHashMap* map, const char* key, int value);
+int concurrentHashMapAdd(ConcurrentHashMap* map, const char* key, int delta);
+void concurrentHashMapRemove(ConcurrentHashMap* map, const char* key);
+int concurrentHashMapSize(ConcurrentHashMap* map);
+
+void concurrentHashMapIteratorInit(ConcurrentHashMapIterator* iterator, ConcurrentHashMap* map);
+int concurrentHashMapIteratorNext(ConcurrentHashMapIterator* iterator, const char** key,
+                                  int* value);
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "dictSnapshot.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+/**
+ * Continues a 64-bit FNV-1a style hash over the given bytes, taking eight
+ * bytes per step so verifying a file stays cheap next to mapping it. Start
+ * from CHECKSUM_BASIS.
+ * @param hash Hash so far.
+ * @param data
+ * @param length
+ * @return Updated hash.
+ */
+uint64_t checksumUpdate(uint64_t hash, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+    while (length >= 8) {
+        uint64_t block;
+        memcpy(&block, bytes, 8);
+        hash ^= block;
+        hash *= 1099511628211ULL;
+        bytes += 8;
+        length -= 8;
+    }
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Hash stored in the slots. 0 marks an empty slot, so it is never returned.
+ * @param function
+ * @param seed
+ * @param key
+ * @return Non-zero hash of the key.
+ */
+static uint32_t snapshotHash(HashFunction function, uint32_t seed, const char *key) {
+    uint32_t hash = function(key, seed);
+    return hash != 0 ? hash : 1;
+}
+
+/**
+ * Saves the keys and values of the map as a snapshot file. Slots are placed
+ * with the map's hash function, which must be one of the built-in ones.
+ * @param map
+ * @param fileName
+ * @return 1 on success, 0 if the file could not be written.
+ */
+int dictSnapshotWrite(HashMap *map, const char *fileName) {
+    assert(map != NULL);
+    assert(fileName != NULL);
+
+    const char *functionName = hashFunctionName(map->hashFunction);
+    assert(functionName != NULL);
+
+    // Keep the slots at most half full so probe sequences stay short
+    uint32_t numSlots = 1;
+    while (numSlots < (uint32_t) hashMapSize(map) * 2) {
+        numSlots *= 2;
+    }
+    SnapshotSlot *slots = calloc(numSlots, sizeof(SnapshotSlot));
+
+    size_t keysLength = 0;
+    HashMapIterator iterator;
+    const char *key;
+    int *value;
+    hashMapIteratorInit(&iterator, map);
+    while (hashMapIteratorNext(&iterator, &key, &value)) {
+        keysLength += strlen(key) + 1;
+    }
+    char *keys = malloc(keysLength > 0 ? keysLength : 1);
+
+    size_t keyOffset = 0;
+    hashMapIteratorInit(&iterator, map);
+    while (hashMapIteratorNext(&iterator, &key, &value)) {
+        uint32_t hash = snapshotHash(map->hashFunction, map->hashSeed, key);
+        uint32_t slot = hash & (numSlots - 1);
+        while (slots[slot].hash != 0) {
+            slot = (slot + 1) & (numSlots - 1);
+        }
+        size_t keyLength = strlen(key);
+        slots[slot].hash = hash;
+        slots[slot].keyOffset = (uint32_t) keyOffset;
+        slots[slot].value = *value;
+        slots[slot].keyLength = (uint32_t) keyLength;
+        memcpy(keys + keyOffset, key, keyLength + 1);
+        keyOffset += keyLength + 1;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.hashSeed = map->hashSeed;
+    strncpy(header.hashFunction, functionName, sizeof(header.hashFunction) - 1);
+    header.numSlots = numSlots;
+    header.numEntries = (uint32_t) hashMapSize(map);
+    header.keysLength = keysLength;
+    header.checksum = checksumUpdate(CHECKSUM_BASIS, slots, sizeof(SnapshotSlot) * numSlots);
+    header.checksum = checksumUpdate(header.checksum, keys, keysLength);
+
+    int written = 0;
+    FILE *file = fopen(fileName, "wb");
+    if (file != NULL) {
+        written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(slots, sizeof(SnapshotSlot), numSlots, file) == numSlots &&
+                  fwrite(keys, 1, keysLength, file) == keysLength;
+        written = fclose(file) == 0 && written;
+    }
+    free(slots);
+    free(keys);
+    return written;
+}
+
+/**
+ * Checks that the slots can be used without reading out of the file: the
+ * packed keys end with a terminator, every occupied slot points at a key of
+ * its length inside them, and the slots hold numEntries keys with at least
+ * one slot left empty, so that every probe ends.
+ * @param header
+ * @param slots
+ * @param keys
+ * @return 1 if the slots are sound, 0 otherwise.
+ */
+static int slotsValid(const SnapshotHeader *header, const SnapshotSlot *slots, const char *keys) {
+    if (header->numEntries >= header->numSlots ||
+        (header->keysLength > 0 && keys[header->keysLength - 1] != '\0')) {
+        return 0;
+    }
+    uint32_t numOccupied = 0;
+    for (uint32_t i = 0; i < header->numSlots; i++) {
+        const SnapshotSlot *slot = &slots[i];
+        if (slot->hash == 0) {
+            continue;
+        }
+        numOccupied++;
+        if ((uint64_t) slot->keyOffset + slot->keyLength >= header->keysLength ||
+            memchr(keys + slot->keyOffset, '\0', slot->keyLength) != NULL ||
+            keys[slot->keyOffset + slot->keyLength] != '\0') {
+            return 0;
+        }
+    }
+    return numOccupied == header->numEntries;
+}
+
+/**
+ * Maps a snapshot file for lookups. The file is rejected if it has the wrong
+ * magic number, version or size, names an unknown hash function, fails the
+ * checksum, or has slots pointing outside the packed keys (see slotsValid).
+ * @param fileName
+ * @return The snapshot, or NULL if the file is missing or invalid.
+ */
+DictSnapshot *dictSnapshotOpen(const char *fileName) {
+    assert(fileName != NULL);
+    MappedFile *file = mappedFileOpen(fileName, 0);
+    if (file == NULL) {
+        return NULL;
+    }
+    const SnapshotHeader *header = (const SnapshotHeader *) file->data;
+    HashFunction function = NULL;
+    if (file->length >= sizeof(SnapshotHeader) &&
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == SNAPSHOT_VERSION &&
+        header->hashFunction[sizeof(header->hashFunction) - 1] == '\0') {
+        function = hashFunctionByName(header->hashFunction);
+    }
+    if (function == NULL || header->numSlots == 0 ||
+        (header->numSlots & (header->numSlots - 1)) != 0 ||
+        file->length != sizeof(SnapshotHeader) +
+                        sizeof(SnapshotSlot) * (size_t) header->numSlots + header->keysLength) {
+        mappedFileClose(file);
+        return NULL;
+    }
+    const char *body = file->data + sizeof(SnapshotHeader);
+    const SnapshotSlot *slots = (const SnapshotSlot *) body;
+    const char *keys = body + sizeof(SnapshotSlot) * header->numSlots;
+    if (checksumUpdate(CHECKSUM_BASIS, body, file->length - sizeof(SnapshotHeader)) != header->checksum ||
+        !slotsValid(header, slots, keys)) {
+        mappedFileClose(file);
+        return NULL;
+    }
+
+    DictSnapshot *snapshot = malloc(sizeof(DictSnapshot));
+    snapshot->file = file;
+    snapshot->header = header;
+    snapshot->slots = slots;
+    snapshot->keys = keys;
+    snapshot->hashFunction = function;
+    return snapshot;
+}
+
+/**
+ * Unmaps the snapshot and frees it.
+ * @param snapshot
+ */
+void dictSnapshotClose(DictSnapshot *snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+    mappedFileClose(snapshot->file);
+    free(snapshot);
+}
+
+/**
+ * Returns a pointer to the value saved with the given key, or NULL if the key
+ * is not in the snapshot.
+ * @param snapshot
+ * @param key
+ * @return Pointer to the value or NULL.
+ */
+const int32_t *dictSnapshotGet(DictSnapshot *snapshot, const char *key) {
+    assert(snapshot != NULL);
+    assert(key != NULL);
+    uint32_t mask = snapshot->header->numSlots - 1;
+    uint32_t hash = snapshotHash(snapshot->hashFunction, snapshot->header->hashSeed, key);
+    for (uint32_t slot = hash & mask; snapshot->slots[slot].hash != 0; slot = (slot + 1) & mask) {
+        const SnapshotSlot *entry = &snapshot->slots[slot];
+        if (entry->hash == hash && strcmp(snapshot->keys + entry->keyOffset, key) == 0) {
+            return &entry->value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns the number of keys in the snapshot.
+ * @param snapshot
+ * @return Number of keys.
+ */
+int dictSnapshotSize(DictSnapshot *snapshot) {
+    assert(snapshot != NULL);
+    return (int) snapshot->header->numEntries;
+}
+
+/**
+ * Walks the packed keys in the order they were saved.
+ * @param snapshot
+ * @param key NULL to get the first key, otherwise the previous key returned.
+ * @return The next key, or NULL after the last one.
+ */
+const char *dictSnapshotNextKey(DictSnapshot *snapshot, const char *key) {
+    assert(snapshot != NULL);
+    const char *next = key == NULL ? snapshot->keys : key + strlen(key) + 1;
+    return next < snapshot->keys + snapshot->header->keysLength ? next : NULL;
+}
@@ -0,0 +1,78 @@
+#ifndef DICT_SNAPSHOT_H
+#define DICT_SNAPSHOT_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "hashMap.h"
+#include "mappedFile.h"
+#include <stdint.h>
+
+/*
+ * Read-only dictionary saved from a built HashMap. The file is a header,
+ * followed by an open addressing slot array and the packed, null terminated
+ * keys, and is used straight from a read-only mapping: opening checks the
+ * header, the checksum and that every slot points inside the keys, and
+ * builds nothing per word. Integers are stored in the byte order of the
+ * machine that wrote the file.
+ *
+ * Slots are probed linearly from hash & (numSlots - 1); a hash of 0 marks an
+ * empty slot.
+ */
+
+#define SNAPSHOT_MAGIC "DICTSNAP"
+#define SNAPSHOT_VERSION 1
+
+// Starting value of checksumUpdate.
+#define CHECKSUM_BASIS 14695981039346656037ULL
+
+typedef struct SnapshotHeader SnapshotHeader;
+typedef struct SnapshotSlot SnapshotSlot;
+typedef struct DictSnapshot DictSnapshot;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    // Seed and name of the hash function the slots were placed with.
+    uint32_t hashSeed;
+    char hashFunction[16];
+    // Number of slots, a power of two.
+    uint32_t numSlots;
+    uint32_t numEntries;
+    // Bytes of packed keys following the slot array.
+    uint64_t keysLength;
+    // FNV-1a style hash of everything after the header.
+    uint64_t checksum;
+};
+
+struct SnapshotSlot
+{
+    uint32_t hash;
+    // Offset of the key in the packed keys.
+    uint32_t keyOffset;
+    int32_t value;
+    uint32_t keyLength;
+};
+
+struct DictSnapshot
+{
+    MappedFile* file;
+    const SnapshotHeader* header;
+    const SnapshotSlot* slots;
+    const char* keys;
+    HashFunction hashFunction;
+};
+
+uint64_t checksumUpdate(uint64_t hash, const void* data, size_t length);
+
+int dictSnapshotWrite(HashMap* map, const char* fileName);
+DictSnapshot* dictSnapshotOpen(const char* fileName);
+void dictSnapshotClose(DictSnapshot* snapshot);
+const int32_t* dictSnapshotGet(DictSnapshot* snapshot, const char* key);
+int dictSnapshotSize(DictSnapshot* snapshot);
+const char* dictSnapshotNextKey(DictSnapshot* snapshot, const char* key);
+
+#endif
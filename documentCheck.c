@@ -0,0 +1,499 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "documentCheck.h"
+#include "ringQueue.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+#include <pthread.h>
+
+// Number of words the reader collects before handing them on.
+#define TOKEN_BATCH_SIZE 4096
+// Batches in flight between two stages.
+#define BATCH_QUEUE_SIZE 16
+// New misspellings waiting for a suggestion worker.
+#define WORK_QUEUE_SIZE 1024
+// Times the writer checks a misspelling's suggestions before going to sleep
+// until they are ready.
+#define READY_SPINS 128
+
+typedef struct TokenBatch TokenBatch;
+typedef struct Pipeline Pipeline;
+
+// Words of the input passed from stage to stage.
+struct TokenBatch
+{
+    // The words, each null terminated, one after the other.
+    char* text;
+    int textLength;
+    int textCapacity;
+    // Start of each word in text.
+    int starts[TOKEN_BATCH_SIZE];
+    long offsets[TOKEN_BATCH_SIZE];
+    // Filled by the lookup stage: the word's entry if it is misspelled, else
+    // NULL.
+    MissEntry* misses[TOKEN_BATCH_SIZE];
+    int count;
+};
+
+struct Pipeline
+{
+    DocumentChecker* checker;
+    FILE* input;
+    int numWorkers;
+    // Reader to lookup, lookup to writer, and lookup to the workers.
+    RingQueue* tokenized;
+    RingQueue* checked;
+    RingQueue* work;
+    MissTable misses;
+    CheckStats stats;
+    // Set while the writer sleeps waiting for suggestions, which the workers
+    // then wake it for.
+    int writerWaiting;
+    pthread_mutex_t readyLock;
+    pthread_cond_t readyChanged;
+};
+
+/**
+ * Returns 1 if the character is part of a word, using the same rules as
+ * nextWord.
+ * @param c
+ * @return 1 for digits, letters and apostrophes, 0 otherwise.
+ */
+static int isWordChar(int c) {
+    return (c >= '0' && c <= '9') ||
+           (c >= 'A' && c <= 'Z') ||
+           (c >= 'a' && c <= 'z') ||
+           c == '\'';
+}
+
+/**
+ * Returns 1 if the word has a letter in it. Words without one, such as
+ * numbers, are not checked.
+ * @param word
+ * @return 1 if the word should be checked.
+ */
+static int hasLetter(const char *word) {
+    return strpbrk(word, "abcdefghijklmnopqrstuvwxyz") != NULL;
+}
+
+/**
+ * Starts reading words from the given file.
+ * @param reader
+ * @param file
+ */
+void wordReaderInit(WordReader *reader, FILE *file) {
+    reader->file = file;
+    reader->offset = 0;
+    reader->maxLength = 64;
+    reader->word = malloc(sizeof(char) * reader->maxLength);
+}
+
+/**
+ * Frees the reader's buffer. The file is not closed.
+ * @param reader
+ */
+void wordReaderCleanUp(WordReader *reader) {
+    free(reader->word);
+}
+
+/**
+ * Reads the next word, lowercased, using the same rules as nextWord. The word
+ * is only valid until the next call. Only one thread may read the file.
+ * @param reader
+ * @param offset Set to the byte offset of the word in the file.
+ * @return The word, or NULL after reaching the end of the file.
+ */
+const char *wordReaderNext(WordReader *reader, long *offset) {
+    int length = 0;
+    int c;
+    while ((c = getc_unlocked(reader->file)) != EOF) {
+        reader->offset++;
+        if (isWordChar(c)) {
+            if (length == 0) {
+                *offset = reader->offset - 1;
+            }
+            if (length + 1 >= reader->maxLength) {
+                reader->maxLength *= 2;
+                reader->word = realloc(reader->word, reader->maxLength);
+            }
+            reader->word[length++] = (char) tolower(c);
+        } else if (length > 0) {
+            break;
+        }
+    }
+    if (length == 0) {
+        return NULL;
+    }
+    reader->word[length] = '\0';
+    return reader->word;
+}
+
+/**
+ * Starts an empty table.
+ * @param table
+ * @param numSuggestions Number of suggestions each entry holds.
+ */
+void missTableInit(MissTable *table, int numSuggestions) {
+    table->map = hashMapNew(1000);
+    hashMapUseArena(table->map);
+    table->arena = arenaNew(ARENA_BLOCK_SIZE);
+    table->size = 0;
+    table->capacity = 256;
+    table->entries = malloc(sizeof(MissEntry *) * table->capacity);
+    table->numSuggestions = numSuggestions;
+}
+
+/**
+ * Frees the table and its entries.
+ * @param table
+ */
+void missTableCleanUp(MissTable *table) {
+    hashMapDelete(table->map);
+    arenaDelete(table->arena);
+    free(table->entries);
+}
+
+/**
+ * Returns the entry of a misspelled word, adding one without suggestions if
+ * the word has not been seen before.
+ * @param table
+ * @param word
+ * @param added Set to 1 if the entry is new, 0 otherwise.
+ * @return The entry.
+ */
+MissEntry *missTableFind(MissTable *table, const char *word, int *added) {
+    int *index = hashMapGet(table->map, word);
+    if (index != NULL) {
+        *added = 0;
+        return table->entries[*index];
+    }
+    if (table->size == table->capacity) {
+        table->capacity *= 2;
+        table->entries = realloc(table->entries, sizeof(MissEntry *) * table->capacity);
+    }
+    MissEntry *entry = arenaAlloc(table->arena, sizeof(MissEntry) +
+                                  sizeof(Suggestion) * table->numSuggestions,
+                                  sizeof(void *));
+    entry->word = arenaStrdup(table->arena, word);
+    entry->ready = 0;
+    entry->numFound = 0;
+    hashMapPut(table->map, word, table->size);
+    table->entries[table->size++] = entry;
+    *added = 1;
+    return entry;
+}
+
+/**
+ * Checks every word of a document on the calling thread and reports each
+ * misspelled one. Tokens without a letter, such as numbers, are skipped.
+ * @param checker
+ * @param input
+ * @param stats Filled with the totals.
+ */
+void checkDocument(DocumentChecker *checker, FILE *input, CheckStats *stats) {
+    MissTable misses;
+    missTableInit(&misses, checker->numSuggestions);
+    stats->words = 0;
+    stats->misses = 0;
+
+    WordReader reader;
+    wordReaderInit(&reader, input);
+    long offset;
+    const char *word;
+    while ((word = wordReaderNext(&reader, &offset)) != NULL) {
+        if (!hasLetter(word)) {
+            continue;
+        }
+        stats->words++;
+        if (checker->contains(checker->context, word)) {
+            continue;
+        }
+        stats->misses++;
+        int added;
+        MissEntry *entry = missTableFind(&misses, word, &added);
+        if (added) {
+            entry->numFound = checker->suggest(checker->context, word, entry->suggestions,
+                                               checker->numSuggestions);
+        }
+        checker->miss(checker->context, offset, word, entry->suggestions, entry->numFound);
+    }
+    stats->bytes = reader.offset;
+    stats->uniqueMisses = misses.size;
+
+    wordReaderCleanUp(&reader);
+    missTableCleanUp(&misses);
+}
+
+/**
+ * Creates an empty batch.
+ * @return The allocated batch.
+ */
+static TokenBatch *tokenBatchNew(void) {
+    TokenBatch *batch = malloc(sizeof(TokenBatch));
+    batch->textCapacity = TOKEN_BATCH_SIZE * 8;
+    batch->text = malloc(batch->textCapacity);
+    batch->textLength = 0;
+    batch->count = 0;
+    return batch;
+}
+
+/**
+ * Frees the batch.
+ * @param batch
+ */
+static void tokenBatchDelete(TokenBatch *batch) {
+    free(batch->text);
+    free(batch);
+}
+
+/**
+ * Reader stage: tokenizes the input into batches. Ends the stream with a
+ * NULL batch.
+ * @param argument The pipeline.
+ * @return NULL.
+ */
+static void *readStage(void *argument) {
+    Pipeline *pipeline = argument;
+    WordReader reader;
+    wordReaderInit(&reader, pipeline->input);
+    TokenBatch *batch = tokenBatchNew();
+    long offset;
+    const char *word;
+    while ((word = wordReaderNext(&reader, &offset)) != NULL) {
+        if (!hasLetter(word)) {
+            continue;
+        }
+        int length = (int) strlen(word) + 1;
+        while (batch->textLength + length > batch->textCapacity) {
+            batch->textCapacity *= 2;
+            batch->text = realloc(batch->text, batch->textCapacity);
+        }
+        memcpy(batch->text + batch->textLength, word, length);
+        batch->starts[batch->count] = batch->textLength;
+        batch->offsets[batch->count] = offset;
+        batch->textLength += length;
+        pipeline->stats.words++;
+        if (++batch->count == TOKEN_BATCH_SIZE) {
+            ringQueuePush(pipeline->tokenized, batch);
+            batch = tokenBatchNew();
+        }
+    }
+    if (batch->count > 0) {
+        ringQueuePush(pipeline->tokenized, batch);
+    } else {
+        tokenBatchDelete(batch);
+    }
+    ringQueuePush(pipeline->tokenized, NULL);
+    pipeline->stats.bytes = reader.offset;
+    wordReaderCleanUp(&reader);
+    return NULL;
+}
+
+/**
+ * Lookup stage: checks the words of each batch, queues every new
+ * misspelling for the suggestion workers and passes the batch on to be
+ * reported. Stops the workers once the input ends.
+ * @param argument The pipeline.
+ * @return NULL.
+ */
+static void *lookupStage(void *argument) {
+    Pipeline *pipeline = argument;
+    DocumentChecker *checker = pipeline->checker;
+    TokenBatch *batch;
+    while ((batch = ringQueuePop(pipeline->tokenized)) != NULL) {
+        for (int i = 0; i < batch->count; i++) {
+            const char *word = batch->text + batch->starts[i];
+            if (checker->contains(checker->context, word)) {
+                batch->misses[i] = NULL;
+                continue;
+            }
+            pipeline->stats.misses++;
+            int added;
+            batch->misses[i] = missTableFind(&pipeline->misses, word, &added);
+            if (added) {
+                ringQueuePush(pipeline->work, batch->misses[i]);
+            }
+        }
+        ringQueuePush(pipeline->checked, batch);
+    }
+    ringQueuePush(pipeline->checked, NULL);
+    for (int i = 0; i < pipeline->numWorkers; i++) {
+        ringQueuePush(pipeline->work, NULL);
+    }
+    return NULL;
+}
+
+/**
+ * Suggestion worker: fills in the suggestions of queued misspellings until
+ * it pops NULL.
+ * @param argument The pipeline.
+ * @return NULL.
+ */
+static void *suggestStage(void *argument) {
+    Pipeline *pipeline = argument;
+    DocumentChecker *checker = pipeline->checker;
+    MissEntry *entry;
+    while ((entry = ringQueuePop(pipeline->work)) != NULL) {
+        entry->numFound = checker->suggest(checker->context, entry->word, entry->suggestions,
+                                           checker->numSuggestions);
+        __atomic_store_n(&entry->ready, 1, __ATOMIC_RELEASE);
+        // Pairs with the fence in waitReady: either the writer sees the entry
+        // ready, or this sees the writer waiting
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pipeline->writerWaiting, __ATOMIC_RELAXED)) {
+            pthread_mutex_lock(&pipeline->readyLock);
+            pthread_cond_broadcast(&pipeline->readyChanged);
+            pthread_mutex_unlock(&pipeline->readyLock);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Waits on the writer's thread until a worker has filled in the entry's
+ * suggestions. Checks a few times and then sleeps until a worker finishes an
+ * entry.
+ * @param pipeline
+ * @param entry
+ */
+static void waitReady(Pipeline *pipeline, MissEntry *entry) {
+    for (int spin = 0; spin < READY_SPINS; spin++) {
+        if (__atomic_load_n(&entry->ready, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+    }
+    pthread_mutex_lock(&pipeline->readyLock);
+    __atomic_store_n(&pipeline->writerWaiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!__atomic_load_n(&entry->ready, __ATOMIC_ACQUIRE)) {
+        pthread_cond_wait(&pipeline->readyChanged, &pipeline->readyLock);
+    }
+    __atomic_store_n(&pipeline->writerWaiting, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pipeline->readyLock);
+}
+
+/**
+ * Stops the suggestion workers that were started and waits for them.
+ * @param pipeline
+ * @param workers
+ * @param numStarted
+ */
+static void stopWorkers(Pipeline *pipeline, pthread_t *workers, int numStarted) {
+    for (int i = 0; i < numStarted; i++) {
+        ringQueuePush(pipeline->work, NULL);
+    }
+    for (int i = 0; i < numStarted; i++) {
+        pthread_join(workers[i], NULL);
+    }
+}
+
+/**
+ * Frees what checkDocumentPipelined set up.
+ * @param pipeline
+ * @param workers
+ */
+static void pipelineCleanUp(Pipeline *pipeline, pthread_t *workers) {
+    free(workers);
+    missTableCleanUp(&pipeline->misses);
+    ringQueueDelete(pipeline->work);
+    ringQueueDelete(pipeline->checked);
+    ringQueueDelete(pipeline->tokenized);
+    pthread_mutex_destroy(&pipeline->readyLock);
+    pthread_cond_destroy(&pipeline->readyChanged);
+}
+
+/**
+ * Checks every word of a document with a pipeline of threads: a reader, a
+ * lookup stage and numWorkers suggestion workers. Misspelled words are
+ * reported on the calling thread in input order, exactly as checkDocument
+ * reports them. The reader starts last, so if any thread fails to start
+ * the input is still unread and the stages already running are stopped
+ * and the document is checked on the calling thread instead.
+ * @param checker
+ * @param input
+ * @param numWorkers At least 1.
+ * @param stats Filled with the totals.
+ */
+void checkDocumentPipelined(DocumentChecker *checker, FILE *input, int numWorkers,
+                            CheckStats *stats) {
+    assert(numWorkers >= 1);
+    Pipeline pipeline;
+    pipeline.checker = checker;
+    pipeline.input = input;
+    pipeline.numWorkers = numWorkers;
+    pipeline.tokenized = ringQueueNew(BATCH_QUEUE_SIZE);
+    pipeline.checked = ringQueueNew(BATCH_QUEUE_SIZE);
+    pipeline.work = ringQueueNew(WORK_QUEUE_SIZE);
+    missTableInit(&pipeline.misses, checker->numSuggestions);
+    memset(&pipeline.stats, 0, sizeof(CheckStats));
+    pipeline.writerWaiting = 0;
+    pthread_mutex_init(&pipeline.readyLock, NULL);
+    pthread_cond_init(&pipeline.readyChanged, NULL);
+
+    pthread_t reader;
+    pthread_t lookup;
+    pthread_t *workers = malloc(sizeof(pthread_t) * numWorkers);
+    int numStarted = 0;
+    while (numStarted < numWorkers &&
+           pthread_create(&workers[numStarted], NULL, suggestStage, &pipeline) == 0) {
+        numStarted++;
+    }
+    if (numStarted < numWorkers) {
+        stopWorkers(&pipeline, workers, numStarted);
+        pipelineCleanUp(&pipeline, workers);
+        checkDocument(checker, input, stats);
+        return;
+    }
+    if (pthread_create(&lookup, NULL, lookupStage, &pipeline) != 0) {
+        stopWorkers(&pipeline, workers, numWorkers);
+        pipelineCleanUp(&pipeline, workers);
+        checkDocument(checker, input, stats);
+        return;
+    }
+    if (pthread_create(&reader, NULL, readStage, &pipeline) != 0) {
+        // Ending the empty stream stops the lookup stage, which stops the
+        // workers
+        ringQueuePush(pipeline.tokenized, NULL);
+        ringQueuePop(pipeline.checked);
+        pthread_join(lookup, NULL);
+        for (int i = 0; i < numWorkers; i++) {
+            pthread_join(workers[i], NULL);
+        }
+        pipelineCleanUp(&pipeline, workers);
+        checkDocument(checker, input, stats);
+        return;
+    }
+
+    // Batches leave the lookup stage in input order, so reporting them as
+    // they arrive keeps the output in order
+    TokenBatch *batch;
+    while ((batch = ringQueuePop(pipeline.checked)) != NULL) {
+        for (int i = 0; i < batch->count; i++) {
+            MissEntry *entry = batch->misses[i];
+            if (entry == NULL) {
+                continue;
+            }
+            waitReady(&pipeline, entry);
+            checker->miss(checker->context, batch->offsets[i], batch->text + batch->starts[i],
+                          entry->suggestions, entry->numFound);
+        }
+        tokenBatchDelete(batch);
+    }
+
+    pthread_join(reader, NULL);
+    pthread_join(lookup, NULL);
+    for (int i = 0; i < numWorkers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    *stats = pipeline.stats;
+    stats->uniqueMisses = pipeline.misses.size;
+    pipelineCleanUp(&pipeline, workers);
+}
@@ -0,0 +1,108 @@
+#ifndef DOCUMENT_CHECK_H
+#define DOCUMENT_CHECK_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <stdio.h>
+#include "arena.h"
+#include "hashMap.h"
+#include "suggestion.h"
+
+/*
+ * Spell checks whole documents. The dictionary is reached through callbacks,
+ * so this does not depend on how it is stored. Every misspelled word is
+ * reported with its byte offset, and suggestions are only looked up the first
+ * time a misspelling is seen.
+ *
+ * checkDocumentPipelined splits the work into stages connected by bounded
+ * lock-free queues: a reader thread tokenizes the input into batches, a
+ * lookup thread checks each word and hands every new misspelling to a pool
+ * of suggestion workers, and the calling thread reports the misses of each
+ * batch in input order as their suggestions become ready. Memory stays
+ * bounded by the queue sizes, apart from one entry per distinct
+ * misspelling.
+ */
+
+typedef struct WordReader WordReader;
+typedef struct CheckStats CheckStats;
+typedef struct DocumentChecker DocumentChecker;
+typedef struct MissEntry MissEntry;
+typedef struct MissTable MissTable;
+
+// Reads the words of a document one at a time into a buffer it reuses,
+// keeping track of where each word starts.
+struct WordReader
+{
+    FILE* file;
+    // Number of bytes read so far.
+    long offset;
+    char* word;
+    int maxLength;
+};
+
+// Totals reported after checking a document.
+struct CheckStats
+{
+    long bytes;
+    long words;
+    long misses;
+    // Number of different misspelled words, each sent to suggest once.
+    long uniqueMisses;
+};
+
+struct DocumentChecker
+{
+    // Passed to every callback.
+    void* context;
+    // Returns 1 if the word is spelled correctly. Only called from one
+    // thread at a time.
+    int (*contains)(void* context, const char* word);
+    // Fills the suggestions for a misspelled word and returns how many were
+    // found. Called from several threads at once by checkDocumentPipelined.
+    int (*suggest)(void* context, const char* word, Suggestion* suggestions,
+                   int numSuggestions);
+    // Reports a misspelled word, in input order, on the calling thread.
+    void (*miss)(void* context, long offset, const char* word, Suggestion* suggestions,
+                 int numFound);
+    int numSuggestions;
+};
+
+// Suggestions for one distinct misspelling.
+struct MissEntry
+{
+    const char* word;
+    // Set once the suggestions have been filled in.
+    int ready;
+    int numFound;
+    Suggestion suggestions[];
+};
+
+// Distinct misspellings seen so far, allocated from an arena so entries
+// never move.
+struct MissTable
+{
+    // Maps each misspelling to its index in entries.
+    HashMap* map;
+    Arena* arena;
+    MissEntry** entries;
+    int size;
+    int capacity;
+    int numSuggestions;
+};
+
+void wordReaderInit(WordReader* reader, FILE* file);
+void wordReaderCleanUp(WordReader* reader);
+const char* wordReaderNext(WordReader* reader, long* offset);
+
+void missTableInit(MissTable* table, int numSuggestions);
+void missTableCleanUp(MissTable* table);
+MissEntry* missTableFind(MissTable* table, const char* word, int* added);
+
+void checkDocument(DocumentChecker* checker, FILE* input, CheckStats* stats);
+void checkDocumentPipelined(DocumentChecker* checker, FILE* input, int numWorkers,
+                            CheckStats* stats);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ * Name: Jessica Speigel
+ * Date: 08/10/2018
+ */
+
+#include "hashMap.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define PRIME64_1 0x9e3779b185ebca87ULL
+#define PRIME64_2 0xc2b2ae3d27d4eb4fULL
+#define PRIME64_3 0x165667b19e3779f9ULL
+#define PRIME64_4 0x85ebca77c2b2ae63ULL
+#define PRIME64_5 0x27d4eb2f165667c5ULL
+
+/**
+ * Sums the character codes. Anagrams always collide.
+ * @param key
+ * @param seed Ignored.
+ * @return Hash of the key.
+ */
+unsigned int hashFunction1(const char *key, unsigned int seed) {
+    (void) seed;
+    unsigned int r = 0;
+    for (int i = 0; key[i] != '\0'; i++) {
+        r += key[i];
+    }
+    return r;
+}
+
+/**
+ * Sums the character codes weighted by position.
+ * @param key
+ * @param seed Ignored.
+ * @return Hash of the key.
+ */
+unsigned int hashFunction2(const char *key, unsigned int seed) {
+    (void) seed;
+    unsigned int r = 0;
+    for (int i = 0; key[i] != '\0'; i++) {
+        r += (i + 1) * key[i];
+    }
+    return r;
+}
+
+/**
+ * 32-bit FNV-1a. The seed is folded into the offset basis.
+ * @param key
+ * @param seed
+ * @return Hash of the key.
+ */
+unsigned int hashFunctionFnv1a(const char *key, unsigned int seed) {
+    unsigned int r = 2166136261u ^ seed;
+    for (int i = 0; key[i] != '\0'; i++) {
+        r ^= (unsigned char) key[i];
+        r *= 16777619u;
+    }
+    return r;
+}
+
+static uint64_t rotateLeft(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+/**
+ * xxHash-style hash that consumes the key eight bytes at a time and finishes
+ * with a full 64-bit avalanche. Different seeds give unrelated hash values, so
+ * a random seed keeps crafted inputs from all landing in one bucket.
+ * @param key
+ * @param seed
+ * @return Hash of the key folded to 32 bits.
+ */
+unsigned int hashFunctionMix64(const char *key, unsigned int seed) {
+    size_t length = strlen(key);
+    uint64_t h = seed + PRIME64_5 + length;
+    while (length >= 8) {
+        uint64_t block;
+        memcpy(&block, key, 8);
+        h ^= rotateLeft(block * PRIME64_2, 31) * PRIME64_1;
+        h = rotateLeft(h, 27) * PRIME64_1 + PRIME64_4;
+        key += 8;
+        length -= 8;
+    }
+    if (length > 0) {
+        uint64_t block = 0;
+        memcpy(&block, key, length);
+        h ^= block * PRIME64_5;
+        h = rotateLeft(h, 11) * PRIME64_1;
+    }
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return (unsigned int) (h ^ (h >> 32));
+}
+
+static const struct
+{
+    const char *name;
+    HashFunction function;
+} hashFunctions[] = {
+    { "sum", hashFunction1 },
+    { "weighted", hashFunction2 },
+    { "fnv1a", hashFunctionFnv1a },
+    { "mix64", hashFunctionMix64 },
+};
+
+/**
+ * Looks up a hash function by its name: "sum", "weighted", "fnv1a" or
+ * "mix64".
+ * @param name
+ * @return The hash function or NULL if the name is unknown.
+ */
+HashFunction hashFunctionByName(const char *name) {
+    for (int i = 0; i < (int) (sizeof(hashFunctions) / sizeof(hashFunctions[0])); i++) {
+        if (strcmp(hashFunctions[i].name, name) == 0) {
+            return hashFunctions[i].function;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns the name hashFunctionByName knows the given function by.
+ * @param function
+ * @return The name or NULL if the function is not a built-in one.
+ */
+const char *hashFunctionName(HashFunction function) {
+    for (int i = 0; i < (int) (sizeof(hashFunctions) / sizeof(hashFunctions[0])); i++) {
+        if (hashFunctions[i].function == function) {
+            return hashFunctions[i].name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns an unpredictable seed for the seeded hash functions, read from
+ * /dev/urandom when it is available.
+ * @return Seed value.
+ */
+unsigned int hashRandomSeed(void) {
+    unsigned int seed = 0;
+    FILE *random = fopen("/dev/urandom", "rb");
+    if (random != NULL) {
+        if (fread(&seed, sizeof(seed), 1, random) != 1) {
+            seed = 0;
+        }
+        fclose(random);
+    }
+    if (seed == 0) {
+        seed = (unsigned int) time(NULL) ^ (unsigned int) clock() ^ (unsigned int) (uintptr_t) &seed;
+    }
+    return seed;
+}
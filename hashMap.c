@@ -12,33 +12,113 @@
 #include <assert.h>
 #include <ctype.h>
 
-int hashFunction1(const char *key) {
-    int r = 0;
-    for (int i = 0; key[i] != '\0'; i++) {
-        r += key[i];
+/**
+ * Hashes the key with the map's hash function.
+ * @param map
+ * @param key
+ * @return Hash of the key.
+ */
+static unsigned int keyHash(HashMap *map, const char *key) {
+    return map->hashFunction(key, map->hashSeed);
+}
+
+/**
+ * Returns the index of the bucket for the given hash. The capacity is a
+ * power of two, so this masks off the low bits.
+ * @param map
+ * @param hash
+ * @return Bucket index.
+ */
+static int bucketIndex(HashMap *map, unsigned int hash) {
+    return (int) (hash & (unsigned int) (hashMapCapacity(map) - 1));
+}
+
+/**
+ * Returns the smallest power of two that is at least the given capacity.
+ * @param capacity
+ * @return Rounded capacity.
+ */
+static int roundCapacity(int capacity) {
+    int rounded = 1;
+    while (rounded < capacity) {
+        rounded *= 2;
     }
-    return r;
+    return rounded;
 }
 
-int hashFunction2(const char *key) {
-    int r = 0;
-    for (int i = 0; key[i] != '\0'; i++) {
-        r += (i + 1) * key[i];
+/**
+ * Returns the bucket that holds the key with the given hash. While an
+ * incremental resize is in progress, keys whose old bucket has not been moved
+ * yet are still found in the old table.
+ * @param map
+ * @param hash
+ * @return Pointer to the head of the bucket's chain.
+ */
+static HashLink **keyBucket(HashMap *map, unsigned int hash) {
+    if (map->oldTable != NULL) {
+        int oldIndex = (int) (hash & (unsigned int) (map->oldCapacity - 1));
+        if (oldIndex >= map->migrated) {
+            return &map->oldTable[oldIndex];
+        }
+    }
+    return &map->table[bucketIndex(map, hash)];
+}
+
+/**
+ * Moves up to the given number of old buckets into the new table, relinking
+ * each link at the front of its new bucket using its stored hash. The old
+ * bucket array is freed once every bucket has been moved.
+ * @param map
+ * @param numBuckets
+ */
+static void migrateBuckets(HashMap *map, int numBuckets) {
+    while (map->oldTable != NULL && numBuckets-- > 0) {
+        HashLink *currentLink = map->oldTable[map->migrated];
+        while (currentLink != NULL) {
+            HashLink *nextLink = currentLink->next;
+            int hashIndex = bucketIndex(map, currentLink->hash);
+            currentLink->next = map->table[hashIndex];
+            map->table[hashIndex] = currentLink;
+            currentLink = nextLink;
+        }
+        map->oldTable[map->migrated] = NULL;
+        map->migrated++;
+        if (map->migrated == map->oldCapacity) {
+            free(map->oldTable);
+            map->oldTable = NULL;
+        }
     }
-    return r;
 }
 
 /**
- * Creates a new hash table link with a copy of the key string.
+ * Creates a new hash table link with a copy of the key string. Arena-backed
+ * maps reuse a link from the free list when there is one and take the link
+ * and key from the arena otherwise.
+ * @param map
  * @param key Key string to copy in the link.
+ * @param hash Hash of the key, kept so the link never needs rehashing.
  * @param value Value to set in the link.
  * @param next Pointer to set as the link's next.
- * @return Hash table link allocated on the heap.
+ * @param borrowKey 1 to store the key pointer itself instead of a copy.
+ * @return Hash table link.
  */
-HashLink *hashLinkNew(const char *key, int value, HashLink *next) {
-    HashLink *link = malloc(sizeof(HashLink));
-    link->key = malloc(sizeof(char) * (strlen(key) + 1));
-    strcpy(link->key, key);
+static HashLink *hashLinkNew(HashMap *map, const char *key, unsigned int hash, int value,
+                             HashLink *next, int borrowKey) {
+    HashLink *link;
+    if (map->arena != NULL) {
+        if (map->freeLinks != NULL) {
+            link = map->freeLinks;
+            map->freeLinks = link->next;
+        } else {
+            link = arenaAlloc(map->arena, sizeof(HashLink), sizeof(void *));
+        }
+        link->key = borrowKey ? (char *) key : arenaStrdup(map->arena, key);
+    } else {
+        link = malloc(sizeof(HashLink));
+        link->key = malloc(sizeof(char) * (strlen(key) + 1));
+        strcpy(link->key, key);
+    }
+    link->hash = hash;
     link->value = value;
     link->next = next;
     return link;
@@ -46,22 +126,41 @@ HashLink *hashLinkNew(const char *key, int value, HashLink *next) {
 
 /**
  * Free the allocated memory for a hash table link created with hashLinkNew.
+ * Links of arena-backed maps go on the free list instead; their key bytes are
+ * only reclaimed when the arena is deleted.
+ * @param map
  * @param link
  */
-static void hashLinkDelete(HashLink *link) {
-    free(link->key);
-    free(link);
+static void hashLinkDelete(HashMap *map, HashLink *link) {
+    if (map->arena != NULL) {
+        link->next = map->freeLinks;
+        map->freeLinks = link;
+    } else {
+        free(link->key);
+        free(link);
+    }
 }
 
 /**
  * Initializes a hash table map, allocating memory for a link pointer table with
- * the given number of buckets.
+ * the given number of buckets rounded up to a power of two.
  * @param map
  * @param capacity The number of table buckets.
  */
 void hashMapInit(HashMap *map, int capacity) {
+    capacity = roundCapacity(capacity);
     map->capacity = capacity;
+    map->maxLoad = MAX_TABLE_LOAD;
+    map->minLoad = MIN_TABLE_LOAD;
     map->size = 0;
+    map->hashFunction = DEFAULT_HASH_FUNCTION;
+    map->hashSeed = 0;
+    map->arena = NULL;
+    map->freeLinks = NULL;
+    map->oldTable = NULL;
+    map->oldCapacity = 0;
+    map->migrated = 0;
+    map->incremental = 0;
     map->table = malloc(sizeof(HashLink *) * capacity);
     for (int i = 0; i < capacity; i++) {
         map->table[i] = NULL;
@@ -75,6 +174,15 @@ void hashMapInit(HashMap *map, int capacity) {
  */
 void hashMapCleanUp(HashMap *map) {
     assert(map != NULL);
+    hashMapFinishResize(map);
+    if (map->arena != NULL) {
+        // Every link and key lives in the arena
+        arenaDelete(map->arena);
+        map->arena = NULL;
+        map->freeLinks = NULL;
+        free(map->table);
+        return;
+    }
     for (int i = 0; i < hashMapCapacity(map); i++) {
         // Loop through the buckets
         if (map->table[i] != NULL) {
@@ -84,7 +192,7 @@ void hashMapCleanUp(HashMap *map) {
             while (currentLink != NULL) {
                 // Loop through the links in the bucket and remove them
                 nextLink = currentLink->next;
-                hashLinkDelete(currentLink);
+                hashLinkDelete(map, currentLink);
                 currentLink = nextLink;
             }
         }
@@ -94,7 +202,7 @@ void hashMapCleanUp(HashMap *map) {
 
 /**
  * Creates a hash table map, allocating memory for a link pointer table with
- * the given number of buckets.
+ * the given number of buckets rounded up to a power of two.
  * @param capacity The number of buckets.
  * @return The allocated map.
  */
@@ -119,7 +227,7 @@ void hashMapDelete(HashMap *map) {
  * Returns a pointer to the value of the link with the given key and skip traversing as well. Returns NULL
  * if no link with that key is in the table.
  * 
- * Use HASH_FUNCTION(key) and the map's capacity to find the index of the
+ * Uses the map's hash function and capacity to find the index of the
  * correct linked list bucket. Also make sure to search the entire list.
  * 
  * @param map
@@ -132,17 +240,13 @@ int *hashMapGet(HashMap *map, const char *key) {
 
     int *returnValue = NULL;
 
-    int capacity = hashMapCapacity(map);
     // Compute the hash value to find the correct bucket
-    int hashIndex = HASH_FUNCTION(key) % capacity;
-    if (hashIndex < 0) {
-        hashIndex += capacity;
-    }
+    unsigned int hash = keyHash(map, key);
 
     // Check to see if the key exists in the table in the bucket it hashes to
-    struct HashLink *currentLink = map->table[hashIndex];
+    struct HashLink *currentLink = *keyBucket(map, hash);
     while (currentLink != NULL) {
-        if (strcmp(currentLink->key, key) == 0) {
+        if (currentLink->hash == hash && strcmp(currentLink->key, key) == 0) {
             // Update the returnValue
             returnValue = &currentLink->value;
             break;
@@ -154,72 +258,123 @@ int *hashMapGet(HashMap *map, const char *key) {
 }
 
 /**
- * Resizes the hash table to have a number of buckets equal to the given 
- * capacity (double of the old capacity). After allocating the new table, 
- * all of the links need to rehashed into it because the capacity has changed.
- * 
- * Remember to free the old table and any old links if you use hashMapPut to
- * rehash them.
+ * Resizes the hash table to have a number of buckets equal to the given
+ * capacity (double or half of the old capacity). The existing links are moved into
+ * the new table using their stored hashes, so no key is rehashed or copied
+ * and no link is reallocated. In incremental mode the old buckets are kept
+ * and moved RESIZE_STEP at a time by the following updates instead.
  * 
  * @param map
  * @param capacity The new number of buckets.
  */
 void resizeTable(HashMap *map, int capacity) {
     assert(map != NULL);
-    assert(capacity > hashMapCapacity(map));
+    assert(capacity > 0 && capacity != hashMapCapacity(map));
 
-    // Create a new table with the new number of buckets
-    struct HashMap *newMap = hashMapNew(capacity);
+    // Only one old table at a time
+    hashMapFinishResize(map);
+    map->oldTable = map->table;
+    map->oldCapacity = hashMapCapacity(map);
+    map->migrated = 0;
 
-    // Loop through all the buckets and links to rehash the values
-    struct HashLink *currentLink;
-    for (int i = 0; i < hashMapCapacity(map); i++) {
-        // Loop through the buckets
-        currentLink = map->table[i];
-        while (currentLink != NULL) {
-            // Add the items to the new table
-            hashMapPut(newMap, currentLink->key, currentLink->value);
-            currentLink = currentLink->next;
-        }
-    }
-    // Delete the old table
-    hashMapCleanUp(map);
-    // Set the old map table to the new map table and update the capacity
-    map->table = newMap->table;
+    // Allocate the new buckets
+    map->table = malloc(sizeof(HashLink *) * capacity);
     map->capacity = capacity;
-    // Delete the temporary map
-    free(newMap);
+    for (int i = 0; i < capacity; i++) {
+        map->table[i] = NULL;
+    }
+
+    if (!map->incremental) {
+        hashMapFinishResize(map);
+    }
 }
 
 /**
- * Updates the given key-value pair in the hash table. If a link with the given
- * key already exists, this will just update the value and skip traversing. Otherwise, it will
- * create a new link with the given key and value and add it to the table
- * bucket's linked list. You can use hashLinkNew to create the link.
- * 
- * Use HASH_FUNCTION(key) and the map's capacity to find the index of the
- * correct linked list bucket.
- * 
+ * Returns the smallest number of buckets, starting from the given power of
+ * two and doubling, that holds the given number of links without going over
+ * the map's maximum load.
+ * @param map
+ * @param numEntries
+ * @param capacity Power of two to start from.
+ * @return Number of buckets.
+ */
+static int capacityFor(HashMap *map, int numEntries, int capacity) {
+    while ((float) numEntries / capacity > map->maxLoad) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * Halves the table, as many times as it takes, if a removal took the load
+ * below the map's minimum, so a map that drains gives its buckets back. The
+ * minimum is under half the maximum, so the smaller table is not about to
+ * grow again.
+ * @param map
+ */
+static void shrinkIfSparse(HashMap *map) {
+    int capacity = hashMapCapacity(map);
+    while (capacity > 1 && (float) hashMapSize(map) / capacity < map->minLoad) {
+        capacity /= 2;
+    }
+    if (capacity < hashMapCapacity(map)) {
+        resizeTable(map, capacity);
+    }
+}
+
+/**
+ * Grows the table, if needed, so that it can hold the given number of links
+ * without going over the maximum load. Loading that many keys afterwards
+ * never resizes, so a loader that knows or can estimate its input size pays
+ * for a single allocation up front instead of a rehash at every doubling.
+ * @param map
+ * @param numEntries Number of links the table should hold.
+ */
+void hashMapReserve(HashMap *map, int numEntries) {
+    assert(map != NULL);
+    int capacity = capacityFor(map, numEntries, hashMapCapacity(map));
+    if (capacity > hashMapCapacity(map)) {
+        resizeTable(map, capacity);
+        hashMapFinishResize(map);
+    }
+}
+
+/**
+ * Shrinks the table to the fewest buckets that hold its links without going
+ * over the maximum load, and finishes any incremental resize, freeing the
+ * old bucket array.
+ * @param map
+ */
+void hashMapCompact(HashMap *map) {
+    assert(map != NULL);
+    int capacity = capacityFor(map, hashMapSize(map), 1);
+    if (capacity < hashMapCapacity(map)) {
+        resizeTable(map, capacity);
+    }
+    hashMapFinishResize(map);
+}
+
+/**
+ * Shared implementation of hashMapPut and hashMapPutBorrowed.
  * @param map
  * @param key
  * @param value
+ * @param borrowKey 1 to store the key pointer instead of a copy.
  */
-void hashMapPut(HashMap *map, const char *key, int value) {
+static void putKey(HashMap *map, const char *key, int value, int borrowKey) {
     assert(map != NULL);
     assert(key != NULL);
+    migrateBuckets(map, RESIZE_STEP);
 
-    int capacity = hashMapCapacity(map);
     // Compute the hash value to find the correct bucket
-    int hashIndex = HASH_FUNCTION(key) % capacity;
-    if (hashIndex < 0) {
-        hashIndex += capacity;
-    }
+    unsigned int hash = keyHash(map, key);
+    HashLink **bucket = keyBucket(map, hash);
 
     // Check to see if the key exists in the table in the bucket it hashes to
-    struct HashLink *currentLink = map->table[hashIndex];
+    struct HashLink *currentLink = *bucket;
     while (currentLink != NULL) {
         //printf("Looking for key: %s // Current key: %s\n", key, currentLink->key);
-        if (strcmp(currentLink->key, key) == 0) {
+        if (currentLink->hash == hash && strcmp(currentLink->key, key) == 0) {
             //printf("Found! Updating value found at map->table[%i], key: %s, to new value: %i (old value: %i)\n", hashIndex, currentLink->key, value, currentLink->value);
             // Update the value and exit the function
             currentLink->value = value;
@@ -230,23 +385,125 @@ void hashMapPut(HashMap *map, const char *key, int value) {
 
     // This code only executes if a matching link wasn't found
     // Create the new link and add it to the bucket
-    HashLink *newLink = hashLinkNew(key, value, map->table[hashIndex]);
+    HashLink *newLink = hashLinkNew(map, key, hash, value, *bucket, borrowKey);
     assert(newLink);
-    map->table[hashIndex] = newLink;
+    *bucket = newLink;
     map->size++;
-    //printf("map->table[%i] // key: %c, value: %i, next: %p\n", hashIndex, *map->table[hashIndex]->key, map->table[hashIndex]->value, map->table[hashIndex]->next);
 
     // Check to see if a resize is necessary
-    if (hashMapTableLoad(map) > MAX_TABLE_LOAD) {
+    if (hashMapTableLoad(map) > map->maxLoad) {
         resizeTable(map, hashMapCapacity(map) * 2);
     }
 
 }
 
+/**
+ * Returns the value of the link with the given key and hash, adding a link
+ * with a copy of the key and the given value first if there is none. Links
+ * never move, so the table can be resized after the insertion.
+ * @param map
+ * @param key
+ * @param hash
+ * @param value Value for a new link.
+ * @return Pointer to the value.
+ */
+static int *getOrInsert(HashMap *map, const char *key, unsigned int hash, int value) {
+    migrateBuckets(map, RESIZE_STEP);
+    HashLink **bucket = keyBucket(map, hash);
+    HashLink *currentLink = *bucket;
+    while (currentLink != NULL) {
+        if (currentLink->hash == hash && strcmp(currentLink->key, key) == 0) {
+            return &currentLink->value;
+        }
+        currentLink = currentLink->next;
+    }
+
+    HashLink *newLink = hashLinkNew(map, key, hash, value, *bucket, 0);
+    *bucket = newLink;
+    map->size++;
+    if (hashMapTableLoad(map) > map->maxLoad) {
+        resizeTable(map, hashMapCapacity(map) * 2);
+    }
+    return &newLink->value;
+}
+
+/**
+ * Returns a pointer to the value of the link with the given key, adding a
+ * link with a copy of the key and the given value first if there is none.
+ * Counting is one call per key, with a single hash and a single walk of the
+ * bucket. The pointer stays valid until the link is removed.
+ * @param map
+ * @param key
+ * @param value Value for a new link.
+ * @return Pointer to the value.
+ */
+int *hashMapGetOrInsert(HashMap *map, const char *key, int value) {
+    assert(map != NULL);
+    assert(key != NULL);
+    return getOrInsert(map, key, keyHash(map, key), value);
+}
+
+/**
+ * Adds delta to the value of each of the given keys, adding missing keys
+ * with the value 0 first. The keys are hashed a batch at a time and their
+ * buckets prefetched, so the cache misses of a batch overlap.
+ * @param map
+ * @param keys
+ * @param numKeys
+ * @param delta
+ */
+void hashMapAddAll(HashMap *map, const char **keys, int numKeys, int delta) {
+    assert(map != NULL);
+    unsigned int hashes[HASH_MAP_BATCH];
+    for (int start = 0; start < numKeys; start += HASH_MAP_BATCH) {
+        int count = numKeys - start < HASH_MAP_BATCH ? numKeys - start : HASH_MAP_BATCH;
+        for (int i = 0; i < count; i++) {
+            hashes[i] = keyHash(map, keys[start + i]);
+            __builtin_prefetch(keyBucket(map, hashes[i]));
+        }
+        for (int i = 0; i < count; i++) {
+            *getOrInsert(map, keys[start + i], hashes[i], 0) += delta;
+        }
+    }
+}
+
+/**
+ * Updates the given key-value pair in the hash table. If a link with the given
+ * key already exists, this will just update the value and skip traversing. Otherwise, it will
+ * create a new link with the given key and value and add it to the table
+ * bucket's linked list. You can use hashLinkNew to create the link.
+ * 
+ * Uses the map's hash function and capacity to find the index of the
+ * correct linked list bucket.
+ * 
+ * @param map
+ * @param key
+ * @param value
+ */
+void hashMapPut(HashMap *map, const char *key, int value) {
+    putKey(map, key, value, 0);
+}
+
+/**
+ * Same as hashMapPut, except that a new link points at the given key instead
+ * of a copy. Only arena-backed maps take borrowed keys, since they never free
+ * keys one at a time, and the key must stay valid and unchanged for as long
+ * as the map holds it.
+ * @param map
+ * @param key
+ * @param value
+ */
+void hashMapPutBorrowed(HashMap *map, const char *key, int value) {
+    assert(map != NULL);
+    assert(map->arena != NULL);
+    putKey(map, key, value, 1);
+}
+
 /**
  * Removes and frees the link with the given key from the table. If no such link
  * exists, this does nothing. Remember to search the entire linked list at the
- * bucket. You can use hashLinkDelete to free the link.
+ * bucket. You can use hashLinkDelete to free the link. The table halves if
+ * the removal takes the load below the map's minimum.
  * @param map
  * @param key
  */
@@ -254,29 +511,29 @@ void hashMapRemove(HashMap *map, const char *key) {
     assert(map != NULL);
     assert(key != NULL);
 
-    int capacity = hashMapCapacity(map);
+    migrateBuckets(map, RESIZE_STEP);
+
     // Compute the hash value to find the correct bucket
-    int hashIndex = HASH_FUNCTION(key) % capacity;
-    if (hashIndex < 0) {
-        hashIndex += capacity;
-    }
+    unsigned int hash = keyHash(map, key);
+    HashLink **bucket = keyBucket(map, hash);
 
     // Check to see if the key exists in the table in the bucket it hashes to
-    struct HashLink *currentLink = map->table[hashIndex];
+    struct HashLink *currentLink = *bucket;
     struct HashLink *lastLink = NULL;
     while (currentLink != NULL) {
-        if (strcmp(currentLink->key, key) == 0) {
+        if (currentLink->hash == hash && strcmp(currentLink->key, key) == 0) {
             if (lastLink == NULL) {
                 // If the key is found at first entry, set beginning to the next entry
-                map->table[hashIndex] = currentLink->next;
+                *bucket = currentLink->next;
             } else {
                 // The value is in the middle, link lastLink and next
                 lastLink->next = currentLink->next;
             }
 
             // Remove the link
-            hashLinkDelete(currentLink);
+            hashLinkDelete(map, currentLink);
             map->size--;
+            shrinkIfSparse(map);
             return;
         }
         lastLink = currentLink;
@@ -287,7 +544,7 @@ void hashMapRemove(HashMap *map, const char *key) {
 /**
  * Returns 1 if a link with the given key is in the table and 0 otherwise.
  * 
- * Use HASH_FUNCTION(key) and the map's capacity to find the index of the
+ * Uses the map's hash function and capacity to find the index of the
  * correct linked list bucket. Also make sure to search the entire list.
  * 
  * @param map
@@ -300,17 +557,13 @@ int hashMapContainsKey(HashMap *map, const char *key) {
 
     int containsKey = 0;
 
-    int capacity = hashMapCapacity(map);
     // Compute the hash value to find the correct bucket
-    int hashIndex = HASH_FUNCTION(key) % capacity;
-    if (hashIndex < 0) {
-        hashIndex += capacity;
-    }
+    unsigned int hash = keyHash(map, key);
 
     // Check to see if the key exists in the table in the bucket it hashes to
-    struct HashLink *currentLink = map->table[hashIndex];
+    struct HashLink *currentLink = *keyBucket(map, hash);
     while (currentLink != NULL) {
-        if (strcmp(currentLink->key, key) == 0) {
+        if (currentLink->hash == hash && strcmp(currentLink->key, key) == 0) {
             // Update the returnValue
             containsKey = 1;
             break;
@@ -342,12 +595,116 @@ int hashMapCapacity(HashMap *map) {
 }
 
 /**
- * Returns the number of table buckets without any links.
+ * Selects the hash function and seed used to place keys. The table must be
+ * empty.
+ * @param map
+ * @param function
+ * @param seed Passed to the hash function with every key.
+ */
+void hashMapSetHashFunction(HashMap *map, HashFunction function, unsigned int seed) {
+    assert(map != NULL);
+    assert(function != NULL);
+    assert(hashMapSize(map) == 0);
+    map->hashFunction = function;
+    map->hashSeed = seed;
+}
+
+/**
+ * Makes the map allocate its links and key copies from an arena it owns, so
+ * inserting does no malloc per link, removed links are recycled through a
+ * free list and hashMapDelete frees everything a block at a time. The table
+ * must be empty.
+ * @param map
+ */
+void hashMapUseArena(HashMap *map) {
+    assert(map != NULL);
+    assert(hashMapSize(map) == 0);
+    if (map->arena == NULL) {
+        map->arena = arenaNew(ARENA_BLOCK_SIZE);
+    }
+}
+
+/**
+ * Sets the load factors of the map: the table doubles when an insertion
+ * takes the load above maxLoad and halves when a removal takes it below
+ * minLoad, with 0 never shrinking. minLoad must be under half of maxLoad so
+ * that a resize in one direction does not immediately call for the other.
+ * The table grows right away if it is already above the new maximum.
+ * @param map
+ * @param minLoad
+ * @param maxLoad
+ */
+void hashMapSetLoadFactors(HashMap *map, float minLoad, float maxLoad) {
+    assert(map != NULL);
+    assert(maxLoad > 0);
+    assert(minLoad >= 0 && minLoad * 2 < maxLoad);
+    map->minLoad = minLoad;
+    map->maxLoad = maxLoad;
+    hashMapReserve(map, hashMapSize(map));
+}
+
+/**
+ * Selects whether growing the table moves every link at once (the default)
+ * or spreads the work over the following updates: the old and new bucket
+ * arrays then coexist, lookups check whichever one still holds the key's
+ * bucket, and each put or remove moves RESIZE_STEP old buckets, so no single
+ * update pays for the whole table. Turning the mode off finishes any resize
+ * in progress.
+ * @param map
+ * @param incremental 1 for incremental resizing, 0 for one-shot.
+ */
+void hashMapSetIncrementalResize(HashMap *map, int incremental) {
+    assert(map != NULL);
+    map->incremental = incremental;
+    if (!incremental) {
+        hashMapFinishResize(map);
+    }
+}
+
+/**
+ * Moves every link still in the old table of an incremental resize into the
+ * new one. Does nothing when no resize is in progress.
+ * @param map
+ */
+void hashMapFinishResize(HashMap *map) {
+    assert(map != NULL);
+    if (map->oldTable != NULL) {
+        migrateBuckets(map, map->oldCapacity - map->migrated);
+    }
+}
+
+/**
+ * Counts the buckets by chain length: histogram[n] is set to the number of
+ * buckets holding n links, and the last bin also counts every longer chain.
+ * @param map
+ * @param histogram Array of numBins counters.
+ * @param numBins
+ */
+void hashMapChainHistogram(HashMap *map, int *histogram, int numBins) {
+    assert(map != NULL);
+    assert(numBins > 0);
+    hashMapFinishResize(map);
+    for (int i = 0; i < numBins; i++) {
+        histogram[i] = 0;
+    }
+    for (int i = 0; i < hashMapCapacity(map); i++) {
+        int length = 0;
+        for (HashLink *link = map->table[i]; link != NULL; link = link->next) {
+            length++;
+        }
+        histogram[length < numBins ? length : numBins - 1]++;
+    }
+}
+
+/**
+ * Returns the number of table buckets without any links. Finishes any
+ * incremental resize first.
  * @param map
  * @return Number of empty buckets.
  */
 int hashMapEmptyBuckets(HashMap *map) {
     assert(map != NULL);
+    hashMapFinishResize(map);
     int emptyBuckets = 0;
     for (int i = 0; i < hashMapCapacity(map); i++) {
         // Loop through the buckets
@@ -378,6 +735,7 @@ float hashMapTableLoad(HashMap *map) {
  */
 void hashMapPrint(HashMap *map) {
     assert(map != NULL);
+    hashMapFinishResize(map);
     for (int i = 0; i < hashMapCapacity(map); i++) {
         // Loop through the buckets
         struct HashLink *currentLink = map->table[i];
@@ -391,3 +749,49 @@ void hashMapPrint(HashMap *map) {
         }
     }
 }
+
+
+/**
+ * Starts an iteration over all the links in the table. The table must not be
+ * modified while iterating, except through the returned value pointers.
+ * @param iterator
+ * @param map
+ */
+void hashMapIteratorInit(HashMapIterator *iterator, HashMap *map) {
+    assert(iterator != NULL);
+    assert(map != NULL);
+    iterator->map = map;
+    iterator->bucket = -1;
+    iterator->link = NULL;
+}
+
+/**
+ * Advances the iterator to the next link in the table.
+ * @param iterator
+ * @param key Set to the link's key.
+ * @param value Set to a pointer to the link's value.
+ * @return 1 if a link was found, 0 once every link has been visited.
+ */
+int hashMapIteratorNext(HashMapIterator *iterator, const char **key, int **value) {
+    assert(iterator != NULL);
+    if (iterator->link != NULL) {
+        iterator->link = iterator->link->next;
+    }
+    HashMap *map = iterator->map;
+    while (iterator->link == NULL) {
+        // Move on to the next non-empty bucket, then through the old buckets
+        // of an incremental resize
+        iterator->bucket++;
+        if (iterator->bucket < hashMapCapacity(map)) {
+            iterator->link = map->table[iterator->bucket];
+        } else if (map->oldTable != NULL
+                   && iterator->bucket - hashMapCapacity(map) < map->oldCapacity) {
+            iterator->link = map->oldTable[iterator->bucket - hashMapCapacity(map)];
+        } else {
+            return 0;
+        }
+    }
+    *key = iterator->link->key;
+    *value = &iterator->link->value;
+    return 1;
+}
@@ -0,0 +1,824 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ *
+ * Open addressing backend for the interface in hashMap.h. Entries live in
+ * parallel arrays of hashes, key pointers and values, and collisions are
+ * resolved with Robin Hood linear probing: an entry being inserted takes the
+ * slot of any entry that is closer to its home slot, which keeps probe
+ * sequences short and lets lookups stop early. Removal shifts the following
+ * entries back, so there are no tombstones.
+ *
+ * An incremental resize drains the old slot arrays a whole cluster at a
+ * time, starting after an empty slot, so whatever is left of the old table is
+ * still a valid Robin Hood table that lookups and removals can probe as usual.
+ */
+
+#include "hashMap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+/**
+ * Hashes the key for storage. Hash function results are run through a
+ * finalizer so that nearby values land in distant slots; linear probing turns
+ * runs of consecutive home slots into long clusters otherwise. 0 marks an
+ * empty slot, so it is never returned.
+ * @param map
+ * @param key
+ * @return Non-zero hash of the key.
+ */
+static unsigned int slotHash(HashMap *map, const char *key) {
+    unsigned int hash = map->hashFunction(key, map->hashSeed);
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash != 0 ? hash : 1;
+}
+
+/**
+ * Returns how far the entry with the given hash stored at the given slot is
+ * from its home slot.
+ * @param capacity Number of slots in the table.
+ * @param hash
+ * @param slot
+ * @return Probe distance.
+ */
+static int probeDistance(int capacity, unsigned int hash, int slot) {
+    int home = (int) (hash & (unsigned int) (capacity - 1));
+    return (slot - home) & (capacity - 1);
+}
+
+/**
+ * Returns the slot of the given slot arrays holding the given key, or -1 if
+ * it is not in them.
+ * @param hashes
+ * @param keys
+ * @param capacity Number of slots in the arrays.
+ * @param key
+ * @param hash Stored hash of the key.
+ * @return Slot index or -1.
+ */
+static int findSlotIn(const unsigned int *hashes, char **keys, int capacity, const char *key,
+                      unsigned int hash) {
+    int slot = (int) (hash & (unsigned int) (capacity - 1));
+    for (int distance = 0; distance < capacity; distance++) {
+        unsigned int stored = hashes[slot];
+        // An empty slot, or an entry richer than we would be here, ends the
+        // probe sequence since the key would have displaced it
+        if (stored == 0 || probeDistance(capacity, stored, slot) < distance) {
+            return -1;
+        }
+        if (stored == hash && strcmp(keys[slot], key) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return -1;
+}
+
+/**
+ * Returns the slot holding the given key, or -1 if it is not in the table.
+ * @param map
+ * @param key
+ * @param hash Stored hash of the key.
+ * @return Slot index or -1.
+ */
+static int findSlot(HashMap *map, const char *key, unsigned int hash) {
+    return findSlotIn(map->hashes, map->keys, map->capacity, key, hash);
+}
+
+/**
+ * Empties the given slot, shifting the following entries of its probe
+ * sequence back one slot.
+ * @param hashes
+ * @param keys
+ * @param values
+ * @param capacity Number of slots in the arrays.
+ * @param slot
+ */
+static void removeSlot(unsigned int *hashes, char **keys, int *values, int capacity, int slot) {
+    int next = (slot + 1) & (capacity - 1);
+    while (hashes[next] != 0 && probeDistance(capacity, hashes[next], next) > 0) {
+        hashes[slot] = hashes[next];
+        keys[slot] = keys[next];
+        values[slot] = values[next];
+        slot = next;
+        next = (next + 1) & (capacity - 1);
+    }
+    hashes[slot] = 0;
+}
+
+/**
+ * Inserts an entry that is known not to be in the table, starting the probe
+ * at the given slot and probe distance, without checking the table load. The
+ * key pointer is stored as is.
+ * @param map
+ * @param slot Slot to start at.
+ * @param distance Probe distance of the entry at that slot.
+ * @param hash
+ * @param key
+ * @param value
+ * @return The slot the entry was stored in.
+ */
+static int insertEntryFrom(HashMap *map, int slot, int distance, unsigned int hash, char *key,
+                           int value) {
+    int placed = -1;
+    while (map->hashes[slot] != 0) {
+        int slotDistance = probeDistance(map->capacity, map->hashes[slot], slot);
+        if (slotDistance < distance) {
+            // Take the slot from the richer entry and carry it forward instead
+            unsigned int swapHash = map->hashes[slot];
+            char *swapKey = map->keys[slot];
+            int swapValue = map->values[slot];
+            map->hashes[slot] = hash;
+            map->keys[slot] = key;
+            map->values[slot] = value;
+            hash = swapHash;
+            key = swapKey;
+            value = swapValue;
+            distance = slotDistance;
+            if (placed < 0) {
+                placed = slot;
+            }
+        }
+        slot = (slot + 1) & (map->capacity - 1);
+        distance++;
+    }
+    map->hashes[slot] = hash;
+    map->keys[slot] = key;
+    map->values[slot] = value;
+    return placed >= 0 ? placed : slot;
+}
+
+/**
+ * Inserts an entry that is known not to be in the table, without checking the
+ * table load. The key pointer is stored as is.
+ * @param map
+ * @param hash
+ * @param key
+ * @param value
+ */
+static void insertEntry(HashMap *map, unsigned int hash, char *key, int value) {
+    insertEntryFrom(map, (int) (hash & (unsigned int) (map->capacity - 1)), 0, hash, key, value);
+}
+
+/**
+ * Moves at least the given number of old slots into the new table, then
+ * keeps going to the end of the current cluster so the old table never holds
+ * part of one. The old arrays are freed once every slot has been visited.
+ * @param map
+ * @param numSlots
+ */
+static void migrateSlots(HashMap *map, int numSlots) {
+    while (map->oldHashes != NULL && (numSlots > 0 || map->oldHashes[map->migrateSlot] != 0)) {
+        int slot = map->migrateSlot;
+        if (map->oldHashes[slot] != 0) {
+            insertEntry(map, map->oldHashes[slot], map->oldKeys[slot], map->oldValues[slot]);
+            map->oldHashes[slot] = 0;
+        }
+        map->migrateSlot = (slot + 1) & (map->oldCapacity - 1);
+        numSlots--;
+        if (++map->migrated == map->oldCapacity) {
+            free(map->oldHashes);
+            free(map->oldKeys);
+            free(map->oldValues);
+            map->oldHashes = NULL;
+        }
+    }
+}
+
+/**
+ * Returns a pointer to the value stored with the given key, looking in the
+ * old table of an incremental resize first, or NULL if the key is in neither.
+ * @param map
+ * @param key
+ * @param hash Stored hash of the key.
+ * @return Pointer to the value or NULL.
+ */
+static int *findValue(HashMap *map, const char *key, unsigned int hash) {
+    if (map->oldHashes != NULL) {
+        int slot = findSlotIn(map->oldHashes, map->oldKeys, map->oldCapacity, key, hash);
+        if (slot >= 0) {
+            return &map->oldValues[slot];
+        }
+    }
+    int slot = findSlot(map, key, hash);
+    return slot >= 0 ? &map->values[slot] : NULL;
+}
+
+/**
+ * Returns a copy of the key for a new entry.
+ * @param map
+ * @param key
+ * @param borrowKey 1 to return the key itself.
+ * @return The key to store.
+ */
+static char *storedKey(HashMap *map, const char *key, int borrowKey) {
+    if (borrowKey) {
+        return (char *) key;
+    }
+    if (map->arena != NULL) {
+        return arenaStrdup(map->arena, key);
+    }
+    char *keyCopy = malloc(sizeof(char) * (strlen(key) + 1));
+    strcpy(keyCopy, key);
+    return keyCopy;
+}
+
+/**
+ * Returns the smallest power of two that is at least the given capacity.
+ * @param capacity
+ * @return Rounded capacity.
+ */
+static int roundCapacity(int capacity) {
+    int rounded = 1;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+/**
+ * Initializes a hash table map, allocating the slot arrays with the given
+ * number of slots rounded up to a power of two, so slot indexes are masked
+ * rather than divided.
+ * @param map
+ * @param capacity The number of table slots.
+ */
+void hashMapInit(HashMap *map, int capacity) {
+    assert(capacity > 0);
+    capacity = roundCapacity(capacity);
+    map->capacity = capacity;
+    map->maxLoad = MAX_TABLE_LOAD;
+    map->minLoad = MIN_TABLE_LOAD;
+    map->size = 0;
+    map->hashFunction = DEFAULT_HASH_FUNCTION;
+    map->hashSeed = 0;
+    map->arena = NULL;
+    map->oldHashes = NULL;
+    map->oldKeys = NULL;
+    map->oldValues = NULL;
+    map->oldCapacity = 0;
+    map->migrateSlot = 0;
+    map->migrated = 0;
+    map->incremental = 0;
+    map->hashes = calloc(capacity, sizeof(unsigned int));
+    map->keys = malloc(sizeof(char *) * capacity);
+    map->values = malloc(sizeof(int) * capacity);
+}
+
+/**
+ * Frees every key and the slot arrays.
+ * @param map
+ */
+void hashMapCleanUp(HashMap *map) {
+    assert(map != NULL);
+    hashMapFinishResize(map);
+    if (map->arena != NULL) {
+        arenaDelete(map->arena);
+        map->arena = NULL;
+    } else {
+        for (int i = 0; i < hashMapCapacity(map); i++) {
+            if (map->hashes[i] != 0) {
+                free(map->keys[i]);
+            }
+        }
+    }
+    free(map->hashes);
+    free(map->keys);
+    free(map->values);
+}
+
+/**
+ * Creates a hash table map with the given number of slots rounded up to a
+ * power of two.
+ * @param capacity The number of slots.
+ * @return The allocated map.
+ */
+HashMap *hashMapNew(int capacity) {
+    HashMap *map = malloc(sizeof(HashMap));
+    hashMapInit(map, capacity);
+    return map;
+}
+
+/**
+ * Removes all entries in the map and frees all allocated memory, including
+ * the map itself.
+ * @param map
+ */
+void hashMapDelete(HashMap *map) {
+    assert(map != NULL);
+    hashMapCleanUp(map);
+    free(map);
+}
+
+/**
+ * Returns a pointer to the value stored with the given key, or NULL if the key
+ * is not in the table. The pointer is invalidated by the next insertion or
+ * removal.
+ * @param map
+ * @param key
+ * @return Pointer to the value or NULL.
+ */
+int *hashMapGet(HashMap *map, const char *key) {
+    assert(map != NULL);
+    assert(key != NULL);
+    return findValue(map, key, slotHash(map, key));
+}
+
+/**
+ * Resizes the table to the given number of slots, which must hold every
+ * entry within the maximum load. Entries are moved using
+ * their stored hashes, so no key is rehashed or copied. In incremental mode
+ * the old slots are kept and moved by the following updates instead.
+ * @param map
+ * @param capacity The new number of slots.
+ */
+void resizeTable(HashMap *map, int capacity) {
+    assert(map != NULL);
+    assert(capacity != hashMapCapacity(map));
+    assert((float) hashMapSize(map) / capacity <= map->maxLoad);
+
+    // Only one old table at a time
+    hashMapFinishResize(map);
+    map->oldHashes = map->hashes;
+    map->oldKeys = map->keys;
+    map->oldValues = map->values;
+    map->oldCapacity = map->capacity;
+    map->migrated = 0;
+    // Start after an empty slot, which the load limit guarantees, so that
+    // clusters are moved whole
+    map->migrateSlot = 0;
+    while (map->oldHashes[map->migrateSlot] != 0) {
+        map->migrateSlot++;
+    }
+
+    map->capacity = capacity;
+    map->hashes = calloc(capacity, sizeof(unsigned int));
+    map->keys = malloc(sizeof(char *) * capacity);
+    map->values = malloc(sizeof(int) * capacity);
+
+    if (!map->incremental) {
+        hashMapFinishResize(map);
+    }
+}
+
+/**
+ * Returns the smallest number of slots, starting from the given power of two
+ * and doubling, that holds the given number of entries without going over
+ * the map's maximum load.
+ * @param map
+ * @param numEntries
+ * @param capacity Power of two to start from.
+ * @return Number of slots.
+ */
+static int capacityFor(HashMap *map, int numEntries, int capacity) {
+    while ((float) numEntries / capacity > map->maxLoad) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * Halves the table, as many times as it takes, if a removal took the load
+ * below the map's minimum, so a map that drains gives its slots back.
+ * @param map
+ */
+static void shrinkIfSparse(HashMap *map) {
+    int capacity = hashMapCapacity(map);
+    while (capacity > 1 && (float) hashMapSize(map) / capacity < map->minLoad) {
+        capacity /= 2;
+    }
+    if (capacity < hashMapCapacity(map)) {
+        resizeTable(map, capacity);
+    }
+}
+
+/**
+ * Grows the table, if needed, so that it can hold the given number of
+ * entries without going over the maximum load. Loading that many keys
+ * afterwards never resizes.
+ * @param map
+ * @param numEntries Number of entries the table should hold.
+ */
+void hashMapReserve(HashMap *map, int numEntries) {
+    assert(map != NULL);
+    int capacity = capacityFor(map, numEntries, hashMapCapacity(map));
+    if (capacity > hashMapCapacity(map)) {
+        resizeTable(map, capacity);
+        hashMapFinishResize(map);
+    }
+}
+
+/**
+ * Shrinks the table to the fewest slots that hold its entries without going
+ * over the maximum load, and finishes any incremental resize, freeing the
+ * old slot arrays.
+ * @param map
+ */
+void hashMapCompact(HashMap *map) {
+    assert(map != NULL);
+    int capacity = capacityFor(map, hashMapSize(map), 1);
+    if (capacity < hashMapCapacity(map)) {
+        resizeTable(map, capacity);
+    }
+    hashMapFinishResize(map);
+}
+
+/**
+ * Shared implementation of hashMapPut and hashMapPutBorrowed.
+ * @param map
+ * @param key
+ * @param value
+ * @param borrowKey 1 to store the key pointer instead of a copy.
+ */
+static void putKey(HashMap *map, const char *key, int value, int borrowKey) {
+    assert(map != NULL);
+    assert(key != NULL);
+    migrateSlots(map, RESIZE_STEP);
+
+    unsigned int hash = slotHash(map, key);
+    int *existing = findValue(map, key, hash);
+    if (existing != NULL) {
+        *existing = value;
+        return;
+    }
+
+    while ((float) (hashMapSize(map) + 1) / hashMapCapacity(map) > map->maxLoad) {
+        resizeTable(map, hashMapCapacity(map) * 2);
+    }
+
+    insertEntry(map, hash, storedKey(map, key, borrowKey), value);
+    map->size++;
+}
+
+/**
+ * Returns the value slot of the key with the given stored hash, inserting a
+ * copy of the key with the given value first if it is not in the table. The
+ * table grows before the probe if an insertion would push the load above
+ * the maximum load, so a single probe both looks for the key and finds where
+ * it belongs.
+ * @param map
+ * @param key
+ * @param hash
+ * @param value Value for a new entry.
+ * @return Pointer to the value.
+ */
+static int *getOrInsert(HashMap *map, const char *key, unsigned int hash, int value) {
+    migrateSlots(map, RESIZE_STEP);
+    while ((float) (hashMapSize(map) + 1) / hashMapCapacity(map) > map->maxLoad) {
+        resizeTable(map, hashMapCapacity(map) * 2);
+    }
+    // Growing may have just moved the key's table aside, so look there after
+    if (map->oldHashes != NULL) {
+        int slot = findSlotIn(map->oldHashes, map->oldKeys, map->oldCapacity, key, hash);
+        if (slot >= 0) {
+            return &map->oldValues[slot];
+        }
+    }
+    int slot = (int) (hash & (unsigned int) (map->capacity - 1));
+    int distance = 0;
+    while (1) {
+        unsigned int stored = map->hashes[slot];
+        // Where the key would stop a lookup is where it gets inserted
+        if (stored == 0 || probeDistance(map->capacity, stored, slot) < distance) {
+            break;
+        }
+        if (stored == hash && strcmp(map->keys[slot], key) == 0) {
+            return &map->values[slot];
+        }
+        slot = (slot + 1) & (map->capacity - 1);
+        distance++;
+    }
+    slot = insertEntryFrom(map, slot, distance, hash, storedKey(map, key, 0), value);
+    map->size++;
+    return &map->values[slot];
+}
+
+/**
+ * Returns a pointer to the value stored with the given key, inserting a copy
+ * of the key with the given value first if it is not in the table. Counting
+ * is one call per key. The pointer is invalidated by the next insertion or
+ * removal.
+ * @param map
+ * @param key
+ * @param value Value for a new entry.
+ * @return Pointer to the value.
+ */
+int *hashMapGetOrInsert(HashMap *map, const char *key, int value) {
+    assert(map != NULL);
+    assert(key != NULL);
+    return getOrInsert(map, key, slotHash(map, key), value);
+}
+
+/**
+ * Adds delta to the value of each of the given keys, inserting missing keys
+ * with the value 0 first. The keys are hashed a batch at a time and their
+ * home slots prefetched, so the cache misses of a batch overlap.
+ * @param map
+ * @param keys
+ * @param numKeys
+ * @param delta
+ */
+void hashMapAddAll(HashMap *map, const char **keys, int numKeys, int delta) {
+    assert(map != NULL);
+    unsigned int hashes[HASH_MAP_BATCH];
+    for (int start = 0; start < numKeys; start += HASH_MAP_BATCH) {
+        int count = numKeys - start < HASH_MAP_BATCH ? numKeys - start : HASH_MAP_BATCH;
+        for (int i = 0; i < count; i++) {
+            hashes[i] = slotHash(map, keys[start + i]);
+            __builtin_prefetch(&map->hashes[hashes[i] & (unsigned int) (map->capacity - 1)]);
+        }
+        for (int i = 0; i < count; i++) {
+            *getOrInsert(map, keys[start + i], hashes[i], 0) += delta;
+        }
+    }
+}
+
+/**
+ * Updates the value stored with the given key, or inserts a copy of the key
+ * with the value if it is not in the table yet. The table grows before the
+ * insertion would push the load above the maximum.
+ * @param map
+ * @param key
+ * @param value
+ */
+void hashMapPut(HashMap *map, const char *key, int value) {
+    putKey(map, key, value, 0);
+}
+
+/**
+ * Same as hashMapPut, except that a new entry points at the given key instead
+ * of a copy. Only arena-backed maps take borrowed keys, since they never free
+ * keys one at a time, and the key must stay valid and unchanged for as long
+ * as the map holds it.
+ * @param map
+ * @param key
+ * @param value
+ */
+void hashMapPutBorrowed(HashMap *map, const char *key, int value) {
+    assert(map != NULL);
+    assert(map->arena != NULL);
+    putKey(map, key, value, 1);
+}
+
+/**
+ * Removes the entry with the given key and frees its key, unless the key is
+ * in the map's arena. Following entries
+ * in the same probe sequence are shifted back one slot. Does nothing if the
+ * key is not in the table. The table halves if the removal takes the load
+ * below the map's minimum.
+ * @param map
+ * @param key
+ */
+void hashMapRemove(HashMap *map, const char *key) {
+    assert(map != NULL);
+    assert(key != NULL);
+    migrateSlots(map, RESIZE_STEP);
+
+    unsigned int hash = slotHash(map, key);
+    if (map->oldHashes != NULL) {
+        int slot = findSlotIn(map->oldHashes, map->oldKeys, map->oldCapacity, key, hash);
+        if (slot >= 0) {
+            if (map->arena == NULL) {
+                free(map->oldKeys[slot]);
+            }
+            removeSlot(map->oldHashes, map->oldKeys, map->oldValues, map->oldCapacity, slot);
+            map->size--;
+            shrinkIfSparse(map);
+            return;
+        }
+    }
+    int slot = findSlot(map, key, hash);
+    if (slot < 0) {
+        return;
+    }
+    if (map->arena == NULL) {
+        free(map->keys[slot]);
+    }
+    removeSlot(map->hashes, map->keys, map->values, map->capacity, slot);
+    map->size--;
+    shrinkIfSparse(map);
+}
+
+/**
+ * Returns 1 if the given key is in the table and 0 otherwise.
+ * @param map
+ * @param key
+ * @return 1 if the key is found, 0 otherwise.
+ */
+int hashMapContainsKey(HashMap *map, const char *key) {
+    assert(map != NULL);
+    assert(key != NULL);
+    return findValue(map, key, slotHash(map, key)) != NULL;
+}
+
+/**
+ * Returns the number of entries in the table.
+ * @param map
+ * @return Number of entries in the table.
+ */
+int hashMapSize(HashMap *map) {
+    assert(map != NULL);
+    return map->size;
+}
+
+/**
+ * Returns the number of slots in the table.
+ * @param map
+ * @return Number of slots in the table.
+ */
+int hashMapCapacity(HashMap *map) {
+    assert(map != NULL);
+    return map->capacity;
+}
+
+/**
+ * Selects the hash function and seed used to place keys. The table must be
+ * empty.
+ * @param map
+ * @param function
+ * @param seed Passed to the hash function with every key.
+ */
+void hashMapSetHashFunction(HashMap *map, HashFunction function, unsigned int seed) {
+    assert(map != NULL);
+    assert(function != NULL);
+    assert(hashMapSize(map) == 0);
+    map->hashFunction = function;
+    map->hashSeed = seed;
+}
+
+/**
+ * Makes the map copy its keys into an arena it owns, so inserting does no
+ * malloc per key and hashMapDelete frees all keys a block at a time. Bytes of
+ * removed keys are only reclaimed when the map is deleted. The table must be
+ * empty.
+ * @param map
+ */
+void hashMapUseArena(HashMap *map) {
+    assert(map != NULL);
+    assert(hashMapSize(map) == 0);
+    if (map->arena == NULL) {
+        map->arena = arenaNew(ARENA_BLOCK_SIZE);
+    }
+}
+
+/**
+ * Sets the load factors of the map: the table doubles when an insertion
+ * would take the load above maxLoad and halves when a removal takes it below
+ * minLoad, with 0 never shrinking. maxLoad must leave at least one empty
+ * slot, and minLoad must be under half of it so that a resize in one
+ * direction does not immediately call for the other. The table grows right
+ * away if it is already above the new maximum.
+ * @param map
+ * @param minLoad
+ * @param maxLoad
+ */
+void hashMapSetLoadFactors(HashMap *map, float minLoad, float maxLoad) {
+    assert(map != NULL);
+    assert(maxLoad > 0 && maxLoad < 1);
+    assert(minLoad >= 0 && minLoad * 2 < maxLoad);
+    map->minLoad = minLoad;
+    map->maxLoad = maxLoad;
+    hashMapReserve(map, hashMapSize(map));
+}
+
+/**
+ * Selects whether growing the table moves every entry at once (the default)
+ * or spreads the work over the following updates: the old and new slot
+ * arrays then coexist, lookups probe both, and each put or remove moves at
+ * least RESIZE_STEP old slots, so no single update pays for the whole table.
+ * Turning the mode off finishes any resize in progress.
+ * @param map
+ * @param incremental 1 for incremental resizing, 0 for one-shot.
+ */
+void hashMapSetIncrementalResize(HashMap *map, int incremental) {
+    assert(map != NULL);
+    map->incremental = incremental;
+    if (!incremental) {
+        hashMapFinishResize(map);
+    }
+}
+
+/**
+ * Moves every entry still in the old table of an incremental resize into the
+ * new one. Does nothing when no resize is in progress.
+ * @param map
+ */
+void hashMapFinishResize(HashMap *map) {
+    assert(map != NULL);
+    if (map->oldHashes != NULL) {
+        migrateSlots(map, map->oldCapacity - map->migrated);
+    }
+}
+
+/**
+ * Counts the entries by the number of slots a lookup probes to find them:
+ * histogram[n] is set to the number of entries found on probe n, with
+ * histogram[0] left at 0 so the bins line up with chain lengths of the
+ * chained backend. The last bin also counts every longer probe.
+ * @param map
+ * @param histogram Array of numBins counters.
+ * @param numBins
+ */
+void hashMapChainHistogram(HashMap *map, int *histogram, int numBins) {
+    assert(map != NULL);
+    assert(numBins > 0);
+    hashMapFinishResize(map);
+    for (int i = 0; i < numBins; i++) {
+        histogram[i] = 0;
+    }
+    for (int i = 0; i < hashMapCapacity(map); i++) {
+        if (map->hashes[i] != 0) {
+            int probes = probeDistance(map->capacity, map->hashes[i], i) + 1;
+            histogram[probes < numBins ? probes : numBins - 1]++;
+        }
+    }
+}
+
+/**
+ * Returns the number of empty slots. Finishes any incremental resize first.
+ * @param map
+ * @return Number of empty slots.
+ */
+int hashMapEmptyBuckets(HashMap *map) {
+    assert(map != NULL);
+    hashMapFinishResize(map);
+    return hashMapCapacity(map) - hashMapSize(map);
+}
+
+/**
+ * Returns the ratio of (number of entries) / (number of slots) in the table.
+ * This never exceeds 1.
+ * @param map
+ * @return Table load.
+ */
+float hashMapTableLoad(HashMap *map) {
+    assert(map != NULL);
+    assert(hashMapCapacity(map) > 0);
+    return (float) hashMapSize(map) / hashMapCapacity(map);
+}
+
+/**
+ * Prints every occupied slot with its entry and probe distance.
+ * @param map
+ */
+void hashMapPrint(HashMap *map) {
+    assert(map != NULL);
+    hashMapFinishResize(map);
+    for (int i = 0; i < hashMapCapacity(map); i++) {
+        if (map->hashes[i] != 0) {
+            printf("\nSlot %i (+%i) -> (%s, %i)", i, probeDistance(map->capacity, map->hashes[i], i),
+                   map->keys[i], map->values[i]);
+        }
+    }
+}
+
+/**
+ * Starts an iteration over all the entries in the table. The table must not be
+ * modified while iterating, except through the returned value pointers.
+ * @param iterator
+ * @param map
+ */
+void hashMapIteratorInit(HashMapIterator *iterator, HashMap *map) {
+    assert(iterator != NULL);
+    assert(map != NULL);
+    iterator->map = map;
+    iterator->slot = -1;
+}
+
+/**
+ * Advances the iterator to the next occupied slot, going on to the old slots
+ * of an incremental resize after the table's own.
+ * @param iterator
+ * @param key Set to the entry's key.
+ * @param value Set to a pointer to the entry's value.
+ * @return 1 if an entry was found, 0 once every entry has been visited.
+ */
+int hashMapIteratorNext(HashMapIterator *iterator, const char **key, int **value) {
+    assert(iterator != NULL);
+    HashMap *map = iterator->map;
+    int oldCapacity = map->oldHashes != NULL ? map->oldCapacity : 0;
+    while (++iterator->slot < hashMapCapacity(map)) {
+        if (map->hashes[iterator->slot] != 0) {
+            *key = map->keys[iterator->slot];
+            *value = &map->values[iterator->slot];
+            return 1;
+        }
+    }
+    while (iterator->slot < hashMapCapacity(map) + oldCapacity) {
+        int slot = iterator->slot - hashMapCapacity(map);
+        if (map->oldHashes[slot] != 0) {
+            *key = map->oldKeys[slot];
+            *value = &map->oldValues[slot];
+            return 1;
+        }
+        iterator->slot++;
+    }
+    iterator->slot = hashMapCapacity(map) + oldCapacity;
+    return 0;
+}
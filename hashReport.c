@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashMap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+
+#define NUM_BINS 10
+
+/**
+ * Allocates a string for the next word in the file and returns it. This string
+ * is null terminated. Returns NULL after reaching the end of the file.
+ * @param file
+ * @return Allocated string or NULL.
+ */
+char *nextWord(FILE *file) {
+    int maxLength = 16;
+    int length = 0;
+    char *word = malloc(sizeof(char) * maxLength);
+    while (1) {
+        char c = (char) fgetc(file);
+        if ((c >= '0' && c <= '9') ||
+            (c >= 'A' && c <= 'Z') ||
+            (c >= 'a' && c <= 'z') ||
+            c == '\'') {
+            if (length + 1 >= maxLength) {
+                maxLength *= 2;
+                word = realloc(word, maxLength);
+            }
+            word[length] = (char) tolower(c);
+            length++;
+        } else if (length > 0 || c == EOF) {
+            break;
+        }
+    }
+    if (length == 0) {
+        free(word);
+        return NULL;
+    }
+    word[length] = '\0';
+    return word;
+}
+
+/**
+ * Loads the words with the given hash function and prints how evenly they
+ * were spread over the table, along with load and lookup times.
+ * @param name Hash function name.
+ * @param seed
+ * @param words
+ * @param numWords
+ */
+void reportHashFunction(const char *name, unsigned int seed, char **words, int numWords) {
+    HashMap *map = hashMapNew(1000);
+    hashMapSetHashFunction(map, hashFunctionByName(name), seed);
+
+    clock_t loadTimer = clock();
+    for (int i = 0; i < numWords; i++) {
+        hashMapPut(map, words[i], i);
+    }
+    loadTimer = clock() - loadTimer;
+
+    clock_t lookupTimer = clock();
+    int found = 0;
+    for (int i = 0; i < numWords; i++) {
+        found += hashMapContainsKey(map, words[i]);
+    }
+    lookupTimer = clock() - lookupTimer;
+
+    int histogram[NUM_BINS];
+    hashMapChainHistogram(map, histogram, NUM_BINS);
+
+    printf("\n%s (seed %u)\n", name, seed);
+    printf("Loaded in %f seconds, looked up %d keys in %f seconds\n",
+           (float) loadTimer / (float) CLOCKS_PER_SEC, found,
+           (float) lookupTimer / (float) CLOCKS_PER_SEC);
+    printf("Keys: %d, buckets: %d, empty buckets: %d\n",
+           hashMapSize(map), hashMapCapacity(map), hashMapEmptyBuckets(map));
+    printf("Chain length distribution:\n");
+    for (int i = 0; i < NUM_BINS; i++) {
+        printf("  %s%d: %d\n", i == NUM_BINS - 1 ? ">=" : "", i, histogram[i]);
+    }
+
+    hashMapDelete(map);
+}
+
+static int compareLongs(const void *left, const void *right) {
+    long a = *(const long *) left;
+    long b = *(const long *) right;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Times every insertion of the words into a map growing from a single bucket
+ * and prints the 99th percentile and slowest insertion, with one-shot and
+ * with incremental resizing.
+ * @param seed
+ * @param words
+ * @param numWords
+ */
+void reportResizeLatency(unsigned int seed, char **words, int numWords) {
+    long *latencies = malloc(sizeof(long) * (numWords > 0 ? numWords : 1));
+    printf("\nInsert latency (mix64)\n");
+    for (int incremental = 0; incremental <= 1; incremental++) {
+        HashMap *map = hashMapNew(1);
+        hashMapSetHashFunction(map, hashFunctionMix64, seed);
+        hashMapSetIncrementalResize(map, incremental);
+        for (int i = 0; i < numWords; i++) {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            hashMapPut(map, words[i], i);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            latencies[i] = (end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec);
+        }
+        hashMapDelete(map);
+        if (numWords == 0) {
+            continue;
+        }
+        qsort(latencies, numWords, sizeof(long), compareLongs);
+        printf("  %-11s p99 %ld ns, slowest %ld ns\n", incremental ? "incremental" : "one-shot",
+               latencies[numWords * 99 / 100], latencies[numWords - 1]);
+    }
+    free(latencies);
+}
+
+/**
+ * Prints the chain length distribution of every hash function over the words
+ * in the given file (dictionary.txt by default). An optional second argument
+ * sets the seed; otherwise a random one is used. Ends with the insert latency
+ * of one-shot and incremental resizing.
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main(int argc, const char **argv) {
+    const char *fileName = argc > 1 ? argv[1] : "dictionary.txt";
+    unsigned int seed = argc > 2 ? (unsigned int) strtoul(argv[2], NULL, 10) : hashRandomSeed();
+
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL) {
+        printf("There was an error opening the file.\n");
+        return 1;
+    }
+    int numWords = 0;
+    int maxWords = 1024;
+    char **words = malloc(sizeof(char *) * maxWords);
+    char *word = nextWord(file);
+    while (word != NULL) {
+        if (numWords == maxWords) {
+            maxWords *= 2;
+            words = realloc(words, sizeof(char *) * maxWords);
+        }
+        words[numWords++] = word;
+        word = nextWord(file);
+    }
+    fclose(file);
+    printf("Read %d words from %s\n", numWords, fileName);
+
+    const char *names[] = { "sum", "weighted", "fnv1a", "mix64" };
+    for (int i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++) {
+        reportHashFunction(names[i], seed, words, numWords);
+    }
+    reportResizeLatency(seed, words, numWords);
+
+    for (int i = 0; i < numWords; i++) {
+        free(words[i]);
+    }
+    free(words);
+    return 0;
+}
@@ -0,0 +1,493 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "levenshtein.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define MIN3(a, b, c) ((a) < (b) ? ((a) < (c) ? (a) : (c)) : ((b) < (c) ? (b) : (c)))
+
+/**
+ * Calculates the Levenshtein distance and returns it.
+ * Adapted from: https://en.wikibooks.org/wiki/Algorithm_Implementation/Strings/Levenshtein_distance#C
+ * @param s1 and s2, two strings to compare
+ * @return an int containing the Levenshtein distance.
+ */
+int computeLevenshtein(const char *s1, const char *s2) {
+    unsigned int s1len, s2len, x, y, lastdiag, olddiag;
+    s1len = strlen(s1);
+    s2len = strlen(s2);
+    unsigned int column[s1len+1];
+    for (y = 0; y <= s1len; y++)
+        column[y] = y;
+    for (x = 1; x <= s2len; x++) {
+        column[0] = x;
+        for (y = 1, lastdiag = x-1; y <= s1len; y++) {
+            olddiag = column[y];
+            column[y] = MIN3(column[y] + 1, column[y-1] + 1, lastdiag + (s1[y-1] == s2[x-1] ? 0 : 1));
+            lastdiag = olddiag;
+        }
+    }
+    return(column[s1len]);
+}
+
+/**
+ * Bit-parallel Levenshtein distance (Myers 1999, in Hyyro's formulation) for
+ * a pattern of 1 to 64 characters. Each bit of Pv and Mv holds whether the
+ * vertical difference between two rows of the DP matrix is +1 or -1, so a
+ * whole column is computed with a handful of word operations. Stops early
+ * once the remaining text can no longer bring the score down to the bound.
+ * @param pattern
+ * @param patternLength
+ * @param text
+ * @param textLength
+ * @param maxDistance
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+static int myersDistance(const char *pattern, int patternLength,
+                         const char *text, int textLength, int maxDistance) {
+    uint64_t peq[256];
+    for (int i = 0; i < patternLength; i++) {
+        peq[(unsigned char) pattern[i]] = 0;
+    }
+    for (int i = 0; i < textLength; i++) {
+        peq[(unsigned char) text[i]] = 0;
+    }
+    for (int i = 0; i < patternLength; i++) {
+        peq[(unsigned char) pattern[i]] |= (uint64_t) 1 << i;
+    }
+
+    uint64_t last = (uint64_t) 1 << (patternLength - 1);
+    uint64_t pv = ~(uint64_t) 0;
+    uint64_t mv = 0;
+    int score = patternLength;
+    for (int j = 0; j < textLength; j++) {
+        uint64_t eq = peq[(unsigned char) text[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last) {
+            score++;
+        } else if (mh & last) {
+            score--;
+        }
+        // Each remaining character can lower the score by at most one
+        if (score - (textLength - j - 1) > maxDistance) {
+            return maxDistance + 1;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score <= maxDistance ? score : maxDistance + 1;
+}
+
+/**
+ * Bit-parallel optimal string alignment distance (Hyyro 2003): the Myers
+ * kernel with one more term in the diagonal mask, TR, marking where swapping
+ * the last two text characters matches two pattern characters. Stops early
+ * in the same way.
+ * @param pattern
+ * @param patternLength From 1 to 64.
+ * @param text
+ * @param textLength
+ * @param maxDistance
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+static int myersDamerau(const char *pattern, int patternLength,
+                        const char *text, int textLength, int maxDistance) {
+    uint64_t peq[256];
+    for (int i = 0; i < patternLength; i++) {
+        peq[(unsigned char) pattern[i]] = 0;
+    }
+    for (int i = 0; i < textLength; i++) {
+        peq[(unsigned char) text[i]] = 0;
+    }
+    for (int i = 0; i < patternLength; i++) {
+        peq[(unsigned char) pattern[i]] |= (uint64_t) 1 << i;
+    }
+
+    uint64_t last = (uint64_t) 1 << (patternLength - 1);
+    uint64_t pv = ~(uint64_t) 0;
+    uint64_t mv = 0;
+    uint64_t d0 = 0;
+    uint64_t previousEq = 0;
+    int score = patternLength;
+    for (int j = 0; j < textLength; j++) {
+        uint64_t eq = peq[(unsigned char) text[j]];
+        uint64_t tr = ((~d0 & eq) << 1) & previousEq;
+        d0 = (((eq & pv) + pv) ^ pv) | eq | mv | tr;
+        uint64_t ph = mv | ~(d0 | pv);
+        uint64_t mh = pv & d0;
+        if (ph & last) {
+            score++;
+        } else if (mh & last) {
+            score--;
+        }
+        if (score - (textLength - j - 1) > maxDistance) {
+            return maxDistance + 1;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(d0 | ph);
+        mv = ph & d0;
+        previousEq = eq;
+    }
+    return score <= maxDistance ? score : maxDistance + 1;
+}
+
+// Row and column of each letter on a QWERTY keyboard. Each row sits a little
+// to the right of the one above, so a key touches the keys at its own column
+// and the next one in the row above, and at its own column and the previous
+// one in the row below.
+static const signed char KEY_ROW[26] = {
+    1, 2, 2, 1, 0, 1, 1, 1, 0, 1, 1, 1, 2, 2, 0, 0, 0, 0, 1, 0, 0, 2, 0, 2, 0, 2
+};
+static const signed char KEY_COLUMN[26] = {
+    0, 4, 2, 2, 2, 3, 4, 5, 7, 6, 7, 8, 6, 5, 8, 9, 0, 3, 1, 4, 6, 3, 1, 1, 5, 0
+};
+
+/**
+ * Cost of typing b where a was meant, in half edits.
+ * @param a
+ * @param b
+ * @return 0 for the same character, 1 for neighbouring letter keys, 2
+ * otherwise.
+ */
+static int keyboardSubstitution(char a, char b) {
+    if (a == b) {
+        return 0;
+    }
+    if (a < 'a' || a > 'z' || b < 'a' || b > 'z') {
+        return 2;
+    }
+    int rows = KEY_ROW[b - 'a'] - KEY_ROW[a - 'a'];
+    int columns = KEY_COLUMN[b - 'a'] - KEY_COLUMN[a - 'a'];
+    if ((rows == 0 && (columns == 1 || columns == -1)) ||
+        (rows == -1 && (columns == 0 || columns == 1)) ||
+        (rows == 1 && (columns == 0 || columns == -1))) {
+        return 1;
+    }
+    return 2;
+}
+
+/**
+ * Optimal string alignment distance by a banded DP kept in three rows, with
+ * either unit costs or keyboard costs. A cell more than maxDistance / indel
+ * off the diagonal can only be reached by that many insertions or deletions,
+ * so only the band is filled. A cell depends on the two rows before it, so
+ * the DP stops once two rows in a row exceed the bound.
+ * @param s1
+ * @param s1len
+ * @param s2
+ * @param s2len
+ * @param maxDistance
+ * @param keyboard 1 for keyboard costs, 0 for unit costs.
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+static int bandedAlignment(const char *s1, int s1len, const char *s2, int s2len,
+                           int maxDistance, int keyboard) {
+    int over = maxDistance + 1;
+    int indel = keyboard ? 2 : 1;
+    int width = maxDistance / indel;
+    int *rows = malloc(sizeof(int) * 3 * (s1len + 1));
+    int *before = rows;
+    int *previous = rows + (s1len + 1);
+    int *current = rows + 2 * (s1len + 1);
+    for (int y = 0; y <= s1len; y++) {
+        previous[y] = y <= width ? y * indel : over;
+    }
+    int previousMin = 0;
+    for (int x = 1; x <= s2len; x++) {
+        int low = x - width > 1 ? x - width : 1;
+        int high = x + width < s1len ? x + width : s1len;
+        current[low - 1] = low == 1 && x <= width ? x * indel : over;
+        int rowMin = current[low - 1];
+        for (int y = low; y <= high; y++) {
+            int substitution = keyboard ? keyboardSubstitution(s1[y - 1], s2[x - 1])
+                                        : s1[y - 1] != s2[x - 1];
+            int value = MIN3(previous[y] + indel, current[y - 1] + indel,
+                             previous[y - 1] + substitution);
+            if (x > 1 && y > 1 && s1[y - 1] == s2[x - 2] && s1[y - 2] == s2[x - 1] &&
+                before[y - 2] + indel < value) {
+                // A swap costs the same as an insertion or deletion
+                value = before[y - 2] + indel;
+            }
+            current[y] = value < over ? value : over;
+            if (current[y] < rowMin) {
+                rowMin = current[y];
+            }
+        }
+        if (high < s1len) {
+            current[high + 1] = over;
+        }
+        if (rowMin > maxDistance && previousMin > maxDistance) {
+            free(rows);
+            return over;
+        }
+        int *swap = before;
+        before = previous;
+        previous = current;
+        current = swap;
+        previousMin = rowMin;
+    }
+    int distance = previous[s1len];
+    free(rows);
+    return distance <= maxDistance ? distance : over;
+}
+
+/**
+ * Row by row Levenshtein distance that only fills the diagonal band the
+ * bound allows and stops as soon as a whole row exceeds the bound, since
+ * values never decrease from one row's minimum to the next.
+ * @param s1
+ * @param s1len
+ * @param s2
+ * @param s2len
+ * @param maxDistance
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+static int bandedDistance(const char *s1, int s1len, const char *s2, int s2len, int maxDistance) {
+    int over = maxDistance + 1;
+    int *row = malloc(sizeof(int) * (s1len + 1));
+    for (int y = 0; y <= s1len; y++) {
+        row[y] = y <= maxDistance ? y : over;
+    }
+    for (int x = 1; x <= s2len; x++) {
+        int low = x - maxDistance > 1 ? x - maxDistance : 1;
+        int high = x + maxDistance < s1len ? x + maxDistance : s1len;
+        int diagonal = row[low - 1];
+        row[low - 1] = low == 1 && x <= maxDistance ? x : over;
+        int rowMin = row[low - 1];
+        for (int y = low; y <= high; y++) {
+            int above = row[y];
+            int value = MIN3(above + 1, row[y - 1] + 1, diagonal + (s1[y - 1] == s2[x - 1] ? 0 : 1));
+            row[y] = value < over ? value : over;
+            diagonal = above;
+            if (row[y] < rowMin) {
+                rowMin = row[y];
+            }
+        }
+        if (high < s1len) {
+            row[high + 1] = over;
+        }
+        if (rowMin > maxDistance) {
+            free(row);
+            return over;
+        }
+    }
+    int distance = row[s1len];
+    free(row);
+    return distance <= maxDistance ? distance : over;
+}
+
+/**
+ * Calculates the Levenshtein distance if it is at most maxDistance. Pairs
+ * whose lengths differ by more than the bound are rejected without any DP,
+ * words of up to 64 characters use the bit-parallel kernel and longer ones a
+ * banded DP, both of which give up as soon as the bound cannot be met.
+ * @param s1
+ * @param s2
+ * @param maxDistance Largest distance of interest, at least 0.
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+int levenshteinBounded(const char *s1, const char *s2, int maxDistance) {
+    assert(maxDistance >= 0);
+    int s1len = (int) strlen(s1);
+    int s2len = (int) strlen(s2);
+    if (s1len - s2len > maxDistance || s2len - s1len > maxDistance) {
+        return maxDistance + 1;
+    }
+    // Use the shorter word as the pattern
+    if (s1len > s2len) {
+        const char *swap = s1;
+        s1 = s2;
+        s2 = swap;
+        int swapLength = s1len;
+        s1len = s2len;
+        s2len = swapLength;
+    }
+    if (s1len == 0) {
+        return s2len;
+    }
+    if (s1len <= 64) {
+        return myersDistance(s1, s1len, s2, s2len, maxDistance);
+    }
+    return bandedDistance(s1, s1len, s2, s2len, maxDistance);
+}
+
+/**
+ * Calculates the optimal string alignment distance if it is at most
+ * maxDistance, rejecting pairs by length and giving up early the same way as
+ * levenshteinBounded.
+ * @param s1
+ * @param s2
+ * @param maxDistance Largest distance of interest, at least 0.
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+int damerauBounded(const char *s1, const char *s2, int maxDistance) {
+    assert(maxDistance >= 0);
+    int s1len = (int) strlen(s1);
+    int s2len = (int) strlen(s2);
+    if (s1len - s2len > maxDistance || s2len - s1len > maxDistance) {
+        return maxDistance + 1;
+    }
+    // Use the shorter word as the pattern
+    if (s1len > s2len) {
+        const char *swap = s1;
+        s1 = s2;
+        s2 = swap;
+        int swapLength = s1len;
+        s1len = s2len;
+        s2len = swapLength;
+    }
+    if (s1len == 0) {
+        return s2len;
+    }
+    if (s1len <= 64) {
+        return myersDamerau(s1, s1len, s2, s2len, maxDistance);
+    }
+    return bandedAlignment(s1, s1len, s2, s2len, maxDistance, 0);
+}
+
+/**
+ * Calculates the keyboard distance, in half edits, if it is at most
+ * maxDistance. Pairs whose lengths differ by more than the bound allows are
+ * rejected without any DP.
+ * @param s1
+ * @param s2
+ * @param maxDistance Largest distance of interest, at least 0.
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+int keyboardDistanceBounded(const char *s1, const char *s2, int maxDistance) {
+    assert(maxDistance >= 0);
+    int s1len = (int) strlen(s1);
+    int s2len = (int) strlen(s2);
+    if ((s1len - s2len) * 2 > maxDistance || (s2len - s1len) * 2 > maxDistance) {
+        return maxDistance + 1;
+    }
+    if (s1len > s2len) {
+        return bandedAlignment(s2, s2len, s1, s1len, maxDistance, 1);
+    }
+    return bandedAlignment(s1, s1len, s2, s2len, maxDistance, 1);
+}
+
+/**
+ * Calculates the distance between the words under the given metric if it
+ * is at most maxDistance.
+ * @param metric One of the METRIC_ constants.
+ * @param s1
+ * @param s2
+ * @param maxDistance Largest distance of interest, at least 0.
+ * @return The distance, or maxDistance + 1 if it exceeds maxDistance.
+ */
+int editDistanceBounded(int metric, const char *s1, const char *s2, int maxDistance) {
+    switch (metric) {
+        case METRIC_DAMERAU:
+            return damerauBounded(s1, s2, maxDistance);
+        case METRIC_KEYBOARD:
+            return keyboardDistanceBounded(s1, s2, maxDistance);
+        default:
+            return levenshteinBounded(s1, s2, maxDistance);
+    }
+}
+
+/**
+ * Returns the largest Levenshtein distance a pair of words within the given
+ * distance under the metric can have. A swap is two Levenshtein edits, and
+ * every keyboard edit costs at least as much as the Levenshtein edits it
+ * stands for.
+ * @param metric
+ * @param maxDistance
+ * @return The Levenshtein radius, at most LEVENSHTEIN_UNBOUNDED.
+ */
+int editDistanceLevenshteinRadius(int metric, int maxDistance) {
+    if (metric == METRIC_DAMERAU) {
+        return maxDistance < LEVENSHTEIN_UNBOUNDED / 2 ? maxDistance * 2 : LEVENSHTEIN_UNBOUNDED;
+    }
+    return maxDistance;
+}
+
+/**
+ * Returns the least a pair of words costs under the metric for each
+ * character one is longer than the other.
+ * @param metric
+ * @return Cost of an insertion or deletion.
+ */
+int editDistanceLengthCost(int metric) {
+    return metric == METRIC_KEYBOARD ? 2 : 1;
+}
+
+/**
+ * Computes the next row of the DP between the query and a word that grows a
+ * character at a time, so that words sharing a prefix share its rows. Row d
+ * holds the distances from the first d characters of the word to each prefix
+ * of the query; row 0 is y * editDistanceLengthCost(metric).
+ * @param metric
+ * @param query
+ * @param queryLength
+ * @param depth Number of word characters the new row covers, at least 1.
+ * @param character Last of those characters.
+ * @param previousCharacter The one before it, if depth is at least 2.
+ * @param previous Row depth - 1.
+ * @param before Row depth - 2, used for swaps if depth is at least 2.
+ * @param row Filled with queryLength + 1 distances.
+ * @return The smallest distance in the row.
+ */
+int editDistanceRow(int metric, const char *query, int queryLength, int depth, char character,
+                    char previousCharacter, const int *previous, const int *before, int *row) {
+    int indel = editDistanceLengthCost(metric);
+    row[0] = depth * indel;
+    int rowMin = row[0];
+    for (int y = 1; y <= queryLength; y++) {
+        int substitution;
+        if (metric == METRIC_KEYBOARD) {
+            substitution = keyboardSubstitution(query[y - 1], character);
+        } else {
+            substitution = query[y - 1] != character;
+        }
+        int value = MIN3(previous[y] + indel, row[y - 1] + indel, previous[y - 1] + substitution);
+        if (metric != METRIC_LEVENSHTEIN && depth > 1 && y > 1 &&
+            query[y - 1] == previousCharacter && query[y - 2] == character &&
+            before[y - 2] + indel < value) {
+            value = before[y - 2] + indel;
+        }
+        row[y] = value;
+        if (value < rowMin) {
+            rowMin = value;
+        }
+    }
+    return rowMin;
+}
+
+static const char *const METRIC_NAMES[] = { "levenshtein", "damerau", "keyboard" };
+
+/**
+ * Returns the name of the metric, as accepted by editMetricByName.
+ * @param metric
+ * @return The name.
+ */
+const char *editMetricName(int metric) {
+    assert(metric >= METRIC_LEVENSHTEIN && metric <= METRIC_KEYBOARD);
+    return METRIC_NAMES[metric];
+}
+
+/**
+ * Looks up a metric by its name.
+ * @param name "levenshtein", "damerau" or "keyboard".
+ * @return The metric, or -1 if the name is unknown.
+ */
+int editMetricByName(const char *name) {
+    for (int metric = METRIC_LEVENSHTEIN; metric <= METRIC_KEYBOARD; metric++) {
+        if (strcmp(name, METRIC_NAMES[metric]) == 0) {
+            return metric;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,41 @@
+#ifndef LEVENSHTEIN_H
+#define LEVENSHTEIN_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+// Bound to pass to levenshteinBounded for an exact distance.
+#define LEVENSHTEIN_UNBOUNDED 0x3fffffff
+
+/*
+ * Edit distances suggestions can be ranked by. Every one has a bounded
+ * version that gives up once the distance exceeds a bound.
+ *
+ * METRIC_DAMERAU is the optimal string alignment distance: Levenshtein plus
+ * swapping two adjacent characters as a single edit, so "teh" is one edit
+ * from "the". METRIC_KEYBOARD is the same alignment in half edits: hitting a
+ * key next to the intended one on a QWERTY keyboard costs 1, and every other
+ * substitution, insertion, deletion or swap costs 2.
+ *
+ * Neither satisfies the triangle inequality, so indexes built on Levenshtein
+ * distance search a Levenshtein radius wide enough to hold every word within
+ * the wanted distance (editDistanceLevenshteinRadius) and measure the words
+ * they find with the wanted metric.
+ */
+enum { METRIC_LEVENSHTEIN, METRIC_DAMERAU, METRIC_KEYBOARD };
+
+int computeLevenshtein(const char* s1, const char* s2);
+int levenshteinBounded(const char* s1, const char* s2, int maxDistance);
+int damerauBounded(const char* s1, const char* s2, int maxDistance);
+int keyboardDistanceBounded(const char* s1, const char* s2, int maxDistance);
+int editDistanceBounded(int metric, const char* s1, const char* s2, int maxDistance);
+int editDistanceLevenshteinRadius(int metric, int maxDistance);
+int editDistanceLengthCost(int metric);
+int editDistanceRow(int metric, const char* query, int queryLength, int depth, char character,
+                    char previousCharacter, const int* previous, const int* before, int* row);
+const char* editMetricName(int metric);
+int editMetricByName(const char* name);
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "levenshteinBatch.h"
+#include "levenshtein.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*BatchKernel)(const char *query, int queryLength, const unsigned char *columns,
+                            int length, unsigned short *distances);
+
+/**
+ * Portable kernel: the same lane-parallel DP as the vector kernels, one lane
+ * at a time. rows holds the previous DP row (one entry per query position)
+ * for every lane.
+ * @param query
+ * @param queryLength
+ * @param columns Transposed block of words of the given length.
+ * @param length
+ * @param distances Set to the distance from the query to each lane's word.
+ */
+static void batchKernelScalar(const char *query, int queryLength, const unsigned char *columns,
+                              int length, unsigned short *distances) {
+    unsigned short rows[(BATCH_MAX_LENGTH + 1) * BATCH_LANES];
+    for (int i = 0; i <= queryLength; i++) {
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            rows[i * BATCH_LANES + lane] = (unsigned short) i;
+        }
+    }
+    for (int j = 1; j <= length; j++) {
+        const unsigned char *c = columns + (j - 1) * BATCH_LANES;
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            unsigned short diagonal = rows[lane];
+            unsigned short left = (unsigned short) j;
+            rows[lane] = left;
+            for (int i = 1; i <= queryLength; i++) {
+                unsigned short above = rows[i * BATCH_LANES + lane];
+                unsigned short value = diagonal + ((unsigned char) query[i - 1] != c[lane]);
+                if (above + 1 < value) {
+                    value = above + 1;
+                }
+                if (left + 1 < value) {
+                    value = left + 1;
+                }
+                rows[i * BATCH_LANES + lane] = value;
+                diagonal = above;
+                left = value;
+            }
+        }
+    }
+    for (int lane = 0; lane < BATCH_LANES; lane++) {
+        distances[lane] = rows[queryLength * BATCH_LANES + lane];
+    }
+}
+
+#ifdef BATCH_X86
+
+/**
+ * AVX2 kernel: all 16 lanes as 16-bit integers in one register.
+ */
+__attribute__((target("avx2")))
+static void batchKernelAvx2(const char *query, int queryLength, const unsigned char *columns,
+                            int length, unsigned short *distances) {
+    __m256i rows[BATCH_MAX_LENGTH + 1];
+    __m256i one = _mm256_set1_epi16(1);
+    for (int i = 0; i <= queryLength; i++) {
+        rows[i] = _mm256_set1_epi16((short) i);
+    }
+    for (int j = 1; j <= length; j++) {
+        __m256i c = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *) (columns + (j - 1) * BATCH_LANES)));
+        __m256i diagonal = rows[0];
+        __m256i left = _mm256_set1_epi16((short) j);
+        rows[0] = left;
+        for (int i = 1; i <= queryLength; i++) {
+            __m256i above = rows[i];
+            // cmpeq gives -1 for a match, so the substitution cost is 1 + eq
+            __m256i eq = _mm256_cmpeq_epi16(c, _mm256_set1_epi16((unsigned char) query[i - 1]));
+            __m256i value = _mm256_add_epi16(diagonal, _mm256_add_epi16(one, eq));
+            value = _mm256_min_epu16(value, _mm256_add_epi16(above, one));
+            value = _mm256_min_epu16(value, _mm256_add_epi16(left, one));
+            rows[i] = value;
+            diagonal = above;
+            left = value;
+        }
+    }
+    _mm256_storeu_si256((__m256i *) distances, rows[queryLength]);
+}
+
+/**
+ * SSE4.1 kernel: the 16 lanes as two registers of 8.
+ */
+__attribute__((target("sse4.1")))
+static void batchKernelSse41(const char *query, int queryLength, const unsigned char *columns,
+                             int length, unsigned short *distances) {
+    __m128i rowsLow[BATCH_MAX_LENGTH + 1];
+    __m128i rowsHigh[BATCH_MAX_LENGTH + 1];
+    __m128i one = _mm_set1_epi16(1);
+    for (int i = 0; i <= queryLength; i++) {
+        rowsLow[i] = _mm_set1_epi16((short) i);
+        rowsHigh[i] = rowsLow[i];
+    }
+    for (int j = 1; j <= length; j++) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (columns + (j - 1) * BATCH_LANES));
+        __m128i cLow = _mm_cvtepu8_epi16(bytes);
+        __m128i cHigh = _mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8));
+        __m128i diagonalLow = rowsLow[0];
+        __m128i diagonalHigh = rowsHigh[0];
+        __m128i leftLow = _mm_set1_epi16((short) j);
+        __m128i leftHigh = leftLow;
+        rowsLow[0] = leftLow;
+        rowsHigh[0] = leftHigh;
+        for (int i = 1; i <= queryLength; i++) {
+            __m128i q = _mm_set1_epi16((unsigned char) query[i - 1]);
+            __m128i aboveLow = rowsLow[i];
+            __m128i aboveHigh = rowsHigh[i];
+            __m128i valueLow = _mm_add_epi16(diagonalLow, _mm_add_epi16(one, _mm_cmpeq_epi16(cLow, q)));
+            __m128i valueHigh = _mm_add_epi16(diagonalHigh, _mm_add_epi16(one, _mm_cmpeq_epi16(cHigh, q)));
+            valueLow = _mm_min_epu16(valueLow, _mm_add_epi16(aboveLow, one));
+            valueHigh = _mm_min_epu16(valueHigh, _mm_add_epi16(aboveHigh, one));
+            valueLow = _mm_min_epu16(valueLow, _mm_add_epi16(leftLow, one));
+            valueHigh = _mm_min_epu16(valueHigh, _mm_add_epi16(leftHigh, one));
+            rowsLow[i] = valueLow;
+            rowsHigh[i] = valueHigh;
+            diagonalLow = aboveLow;
+            diagonalHigh = aboveHigh;
+            leftLow = valueLow;
+            leftHigh = valueHigh;
+        }
+    }
+    _mm_storeu_si128((__m128i *) distances, rowsLow[queryLength]);
+    _mm_storeu_si128((__m128i *) (distances + 8), rowsHigh[queryLength]);
+}
+
+#endif
+
+static const char *const BATCH_KERNEL_NAMES[] = { "avx2", "sse4.1", "scalar" };
+
+static pthread_once_t batchKernelOnce = PTHREAD_ONCE_INIT;
+// Kernel levenshteinBatch uses, written once by batchKernelSelect.
+static int batchKernel = BATCH_KERNEL_SCALAR;
+
+/**
+ * Returns the function of a kernel.
+ * @param kernel One of the BATCH_KERNEL_ constants.
+ * @return The kernel, or NULL if it is not built for this architecture.
+ */
+static BatchKernel batchKernelFunction(int kernel) {
+    switch (kernel) {
+#ifdef BATCH_X86
+    case BATCH_KERNEL_AVX2:
+        return batchKernelAvx2;
+    case BATCH_KERNEL_SSE41:
+        return batchKernelSse41;
+#endif
+    case BATCH_KERNEL_SCALAR:
+        return batchKernelScalar;
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * Checks whether the CPU runs a kernel. Only called after
+ * __builtin_cpu_init, which batchKernelSelect runs once.
+ * @param kernel
+ * @return 1 or 0.
+ */
+static int batchKernelRuns(int kernel) {
+    switch (kernel) {
+#ifdef BATCH_X86
+    case BATCH_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case BATCH_KERNEL_SSE41:
+        return __builtin_cpu_supports("sse4.1");
+#endif
+    case BATCH_KERNEL_SCALAR:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Picks the widest kernel the CPU supports. Runs once through pthread_once,
+ * so that search threads all see the same finished choice.
+ */
+static void batchKernelSelect(void) {
+#ifdef BATCH_X86
+    __builtin_cpu_init();
+#endif
+    int kernel = 0;
+    while (!batchKernelRuns(kernel)) {
+        kernel++;
+    }
+    batchKernel = kernel;
+}
+
+/**
+ * Computes the edit distance from the query to each of the BATCH_LANES words
+ * of a transposed block.
+ * @param query
+ * @param queryLength At most BATCH_MAX_LENGTH.
+ * @param columns length * BATCH_LANES characters, position-major.
+ * @param length Length of every word in the block, at most BATCH_MAX_LENGTH.
+ * @param distances Array of BATCH_LANES results.
+ */
+void levenshteinBatch(const char *query, int queryLength, const unsigned char *columns,
+                      int length, unsigned short *distances) {
+    pthread_once(&batchKernelOnce, batchKernelSelect);
+    levenshteinBatchWithKernel(batchKernel, query, queryLength, columns, length, distances);
+}
+
+/**
+ * Same as levenshteinBatch with the given kernel instead of the one picked
+ * for the CPU, so that every kernel can be checked.
+ * @param kernel A kernel levenshteinBatchKernelSupported accepts.
+ * @param query
+ * @param queryLength At most BATCH_MAX_LENGTH.
+ * @param columns length * BATCH_LANES characters, position-major.
+ * @param length Length of every word in the block, at most BATCH_MAX_LENGTH.
+ * @param distances Array of BATCH_LANES results.
+ */
+void levenshteinBatchWithKernel(int kernel, const char *query, int queryLength,
+                                const unsigned char *columns, int length,
+                                unsigned short *distances) {
+    assert(queryLength <= BATCH_MAX_LENGTH);
+    assert(length <= BATCH_MAX_LENGTH);
+    assert(kernel >= 0 && kernel < BATCH_NUM_KERNELS);
+    batchKernelFunction(kernel)(query, queryLength, columns, length, distances);
+}
+
+/**
+ * Checks whether a kernel is built for this architecture and the CPU runs
+ * it.
+ * @param kernel One of the BATCH_KERNEL_ constants.
+ * @return 1 or 0.
+ */
+int levenshteinBatchKernelSupported(int kernel) {
+    pthread_once(&batchKernelOnce, batchKernelSelect);
+    return kernel >= 0 && kernel < BATCH_NUM_KERNELS && batchKernelFunction(kernel) != NULL &&
+           batchKernelRuns(kernel);
+}
+
+/**
+ * Returns the name of a kernel.
+ * @param kernel One of the BATCH_KERNEL_ constants.
+ * @return "avx2", "sse4.1" or "scalar".
+ */
+const char *levenshteinBatchKernelNameOf(int kernel) {
+    assert(kernel >= 0 && kernel < BATCH_NUM_KERNELS);
+    return BATCH_KERNEL_NAMES[kernel];
+}
+
+/**
+ * Returns the name of the kernel levenshteinBatch uses on this CPU.
+ * @return "avx2", "sse4.1" or "scalar".
+ */
+const char *levenshteinBatchKernelName(void) {
+    pthread_once(&batchKernelOnce, batchKernelSelect);
+    return BATCH_KERNEL_NAMES[batchKernel];
+}
+
+typedef struct BatchWord BatchWord;
+
+// A word being sorted into the batch.
+struct BatchWord {
+    const char *word;
+    int length;
+    int frequency;
+};
+
+static int compareLengths(const void *a, const void *b) {
+    int lengthA = ((const BatchWord *) a)->length;
+    int lengthB = ((const BatchWord *) b)->length;
+    return (lengthA > lengthB) - (lengthA < lengthB);
+}
+
+/**
+ * Groups the words by length into transposed blocks. The batch keeps
+ * pointers to the words, which must outlive it.
+ * @param words
+ * @param frequencies How common each word is, used to rank words at equal
+ * distance, or NULL if they are all equally common.
+ * @param numWords
+ * @return The allocated batch.
+ */
+WordBatch *wordBatchNew(const char **words, const int *frequencies, int numWords) {
+    BatchWord *sorted = malloc(sizeof(BatchWord) * (numWords > 0 ? numWords : 1));
+    for (int i = 0; i < numWords; i++) {
+        sorted[i].word = words[i];
+        sorted[i].length = (int) strlen(words[i]);
+        sorted[i].frequency = frequencies != NULL ? frequencies[i] : 0;
+    }
+    qsort(sorted, numWords, sizeof(BatchWord), compareLengths);
+
+    WordBatch *batch = malloc(sizeof(WordBatch));
+    batch->blocks = malloc(sizeof(WordBlock) * (numWords / BATCH_LANES + BATCH_MAX_LENGTH + 1));
+    batch->numBlocks = 0;
+    batch->longWords = malloc(sizeof(char *) * (numWords > 0 ? numWords : 1));
+    batch->longFrequencies = malloc(sizeof(int) * (numWords > 0 ? numWords : 1));
+    batch->numLongWords = 0;
+    batch->stopDistance = -1;
+    batch->stopFrequency = 0;
+
+    int i = 0;
+    int nextLength = 0;
+    while (i < numWords) {
+        int length = sorted[i].length;
+        while (nextLength <= length && nextLength <= BATCH_MAX_LENGTH + 1) {
+            batch->lengthStart[nextLength++] = batch->numBlocks;
+        }
+        if (length > BATCH_MAX_LENGTH) {
+            batch->longWords[batch->numLongWords] = sorted[i].word;
+            batch->longFrequencies[batch->numLongWords++] = sorted[i].frequency;
+            i++;
+            continue;
+        }
+        WordBlock *block = &batch->blocks[batch->numBlocks++];
+        block->length = length;
+        block->numWords = 0;
+        block->columns = calloc((size_t) (length > 0 ? length : 1) * BATCH_LANES, 1);
+        while (i < numWords && block->numWords < BATCH_LANES && sorted[i].length == length) {
+            int lane = block->numWords++;
+            block->words[lane] = sorted[i].word;
+            block->frequencies[lane] = sorted[i].frequency;
+            for (int j = 0; j < length; j++) {
+                block->columns[j * BATCH_LANES + lane] = (unsigned char) sorted[i].word[j];
+            }
+            i++;
+        }
+    }
+    while (nextLength <= BATCH_MAX_LENGTH + 1) {
+        batch->lengthStart[nextLength++] = batch->numBlocks;
+    }
+    free(sorted);
+    return batch;
+}
+
+/**
+ * Frees the batch. The words are not freed.
+ * @param batch
+ */
+void wordBatchDelete(WordBatch *batch) {
+    assert(batch != NULL);
+    for (int i = 0; i < batch->numBlocks; i++) {
+        free(batch->blocks[i].columns);
+    }
+    free(batch->blocks);
+    free(batch->longWords);
+    free(batch->longFrequencies);
+    free(batch);
+}
+
+/**
+ * Makes searches stop as soon as they have found numSuggestions words, each
+ * within stopDistance of the query and with a frequency of at least
+ * stopFrequency (see topKSetStop). A search split over partitions stops
+ * each partition separately.
+ * @param batch
+ * @param stopDistance -1 to always search every word.
+ * @param stopFrequency
+ */
+void wordBatchSetEarlyStop(WordBatch *batch, int stopDistance, int stopFrequency) {
+    assert(batch != NULL);
+    batch->stopDistance = stopDistance;
+    batch->stopFrequency = stopFrequency;
+}
+
+/**
+ * Computes the distance from the query to every word of the given length in
+ * the caller's partition and offers them to the suggestions. For metrics
+ * other than Levenshtein, the kernel's Levenshtein distances pick out the
+ * words that can be within reach, and only those are measured again with
+ * the metric.
+ * @param batch
+ * @param query
+ * @param queryLength
+ * @param length
+ * @param topK
+ * @param metric
+ * @param part
+ * @param numParts
+ */
+static void searchLength(WordBatch *batch, const char *query, int queryLength, int length,
+                         TopK *topK, int metric, int part, int numParts) {
+    unsigned short distances[BATCH_LANES];
+    for (int b = batch->lengthStart[length] + part;
+         b < batch->lengthStart[length + 1] && !topKDone(topK); b += numParts) {
+        WordBlock *block = &batch->blocks[b];
+        levenshteinBatch(query, queryLength, block->columns, block->length, distances);
+        int bound = topKBound(topK);
+        int radius = editDistanceLevenshteinRadius(metric, bound);
+        for (int lane = 0; lane < block->numWords; lane++) {
+            if (distances[lane] > radius) {
+                continue;
+            }
+            int distance = metric == METRIC_LEVENSHTEIN
+                           ? distances[lane]
+                           : editDistanceBounded(metric, query, block->words[lane], bound);
+            if (distance <= bound) {
+                topKOffer(topK, block->words[lane], distance, block->frequencies[lane]);
+                bound = topKBound(topK);
+                radius = editDistanceLevenshteinRadius(metric, bound);
+            }
+        }
+    }
+}
+
+/**
+ * Finds the words closest to the query by computing the distance to every
+ * word, a block at a time. Lengths are visited outwards from the query's
+ * length, and the search stops once the length difference alone exceeds the
+ * farthest suggestion kept so far, or once the suggestions are good enough if
+ * an early stop is set.
+ * @param batch
+ * @param query
+ * @param suggestions Filled with the closest words, nearest first.
+ * @param numSuggestions Number of words wanted.
+ * @param metric Distance to rank the words by, one of the METRIC_ constants.
+ * @return Number of suggestions found.
+ */
+int wordBatchSearch(WordBatch *batch, const char *query, Suggestion *suggestions,
+                    int numSuggestions, int metric) {
+    return wordBatchSearchPart(batch, query, suggestions, numSuggestions, metric, 0, 1);
+}
+
+/**
+ * Same as wordBatchSearch, but only over one of numParts interleaved
+ * partitions of the words: blocks part, part + numParts, part + 2 * numParts
+ * and so on. Interleaving keeps every length spread over all the partitions,
+ * so each one prunes by length as well as a whole search would. The batch is
+ * only read, so the partitions can be searched by different threads at once.
+ * @param batch
+ * @param query
+ * @param suggestions Filled with the closest words of the partition.
+ * @param numSuggestions
+ * @param metric
+ * @param part Partition to search, from 0 to numParts - 1.
+ * @param numParts
+ * @return Number of suggestions found.
+ */
+int wordBatchSearchPart(WordBatch *batch, const char *query, Suggestion *suggestions,
+                        int numSuggestions, int metric, int part, int numParts) {
+    assert(batch != NULL);
+    assert(query != NULL);
+    assert(part >= 0 && part < numParts);
+    TopK topK;
+    topKInit(&topK, suggestions, numSuggestions);
+    topKSetStop(&topK, batch->stopDistance, batch->stopFrequency);
+    int queryLength = (int) strlen(query);
+    int lengthCost = editDistanceLengthCost(metric);
+    if (queryLength <= BATCH_MAX_LENGTH) {
+        for (int difference = 0; difference <= BATCH_MAX_LENGTH; difference++) {
+            if (difference * lengthCost > topKBound(&topK) || topKDone(&topK)) {
+                break;
+            }
+            if (queryLength - difference >= 0) {
+                searchLength(batch, query, queryLength, queryLength - difference, &topK,
+                             metric, part, numParts);
+            }
+            if (difference > 0 && queryLength + difference <= BATCH_MAX_LENGTH) {
+                searchLength(batch, query, queryLength, queryLength + difference, &topK,
+                             metric, part, numParts);
+            }
+        }
+    } else {
+        for (int b = part; b < batch->numBlocks; b += numParts) {
+            WordBlock *block = &batch->blocks[b];
+            for (int lane = 0; lane < block->numWords; lane++) {
+                int distance = editDistanceBounded(metric, query, block->words[lane],
+                                                   topKBound(&topK));
+                topKOffer(&topK, block->words[lane], distance, block->frequencies[lane]);
+            }
+        }
+    }
+    for (int i = part; i < batch->numLongWords; i += numParts) {
+        int distance = editDistanceBounded(metric, query, batch->longWords[i], topKBound(&topK));
+        topKOffer(&topK, batch->longWords[i], distance, batch->longFrequencies[i]);
+    }
+    return topKFinish(&topK);
+}
@@ -0,0 +1,77 @@
+#ifndef LEVENSHTEIN_BATCH_H
+#define LEVENSHTEIN_BATCH_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "suggestion.h"
+
+/*
+ * Edit distance from one query to many words at once. Words are grouped by
+ * length and stored in blocks of BATCH_LANES words, transposed so that the
+ * BATCH_LANES characters at each position are contiguous: one vector load
+ * gives one character of every word in the block, and each lane of the DP
+ * belongs to one word. The kernel is picked at run time from AVX2, SSE4.1
+ * and a portable scalar version.
+ */
+
+#define BATCH_LANES 16
+// Longest query and word the batch kernel handles; longer ones fall back to
+// levenshteinBounded.
+#define BATCH_MAX_LENGTH 255
+
+// Batch kernels, widest first; levenshteinBatch uses the first one the CPU
+// supports.
+enum { BATCH_KERNEL_AVX2, BATCH_KERNEL_SSE41, BATCH_KERNEL_SCALAR, BATCH_NUM_KERNELS };
+
+typedef struct WordBlock WordBlock;
+typedef struct WordBatch WordBatch;
+
+struct WordBlock
+{
+    // Length shared by every word in the block.
+    int length;
+    // Number of lanes in use, the rest hold padding.
+    int numWords;
+    const char* words[BATCH_LANES];
+    int frequencies[BATCH_LANES];
+    // length * BATCH_LANES characters, position-major.
+    unsigned char* columns;
+};
+
+struct WordBatch
+{
+    // Blocks sorted by word length.
+    WordBlock* blocks;
+    int numBlocks;
+    // Index of the first block of each length; the blocks of length n are
+    // lengthStart[n] up to lengthStart[n + 1].
+    int lengthStart[BATCH_MAX_LENGTH + 2];
+    // Words too long for the kernel, and their frequencies.
+    const char** longWords;
+    int* longFrequencies;
+    int numLongWords;
+    // Searches stop early as set by wordBatchSetEarlyStop, never by default.
+    int stopDistance;
+    int stopFrequency;
+};
+
+void levenshteinBatch(const char* query, int queryLength, const unsigned char* columns,
+                      int length, unsigned short* distances);
+void levenshteinBatchWithKernel(int kernel, const char* query, int queryLength,
+                                const unsigned char* columns, int length, unsigned short* distances);
+int levenshteinBatchKernelSupported(int kernel);
+const char* levenshteinBatchKernelNameOf(int kernel);
+const char* levenshteinBatchKernelName(void);
+
+WordBatch* wordBatchNew(const char** words, const int* frequencies, int numWords);
+void wordBatchSetEarlyStop(WordBatch* batch, int stopDistance, int stopFrequency);
+void wordBatchDelete(WordBatch* batch);
+int wordBatchSearch(WordBatch* batch, const char* query, Suggestion* suggestions,
+                    int numSuggestions, int metric);
+int wordBatchSearchPart(WordBatch* batch, const char* query, Suggestion* suggestions,
+                        int numSuggestions, int metric, int part, int numParts);
+
+#endif
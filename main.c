@@ -1,4 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "hashMap.h"
+#include "mappedFile.h"
+#include "wordCount.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -42,59 +47,415 @@ char *nextWord(FILE *file) {
     return word;
 }
 
+// Seed of the hash that assigns words to partitions, kept apart from the
+// maps' own seed so partitions do not correlate with buckets.
+#define PARTITION_SEED 0x9e3779b9u
+
+// Most threads the parallel count uses. Each thread keeps a map per
+// partition, so the number of maps grows with the square of the threads.
+#define MAX_COUNT_THREADS 64
+
+// Size of the output buffer of the sorted and top-N listings.
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+// Bytes per word of running text, separator included, and the constant of
+// the Heaps' law estimate of distinct words used to size the count maps.
+#define BYTES_PER_WORD 6
+#define HEAPS_CONSTANT 40
+
+typedef struct CountTask CountTask;
+typedef struct MergeTask MergeTask;
+typedef struct OutputBuffer OutputBuffer;
+
+// One chunk of the input, counted by one thread into one map per partition.
+struct CountTask {
+    const char *start;
+    const char *end;
+    int numPartitions;
+    HashMap **partitions;
+};
+
+// One partition, merged by one thread from every count task.
+struct MergeTask {
+    int partition;
+    CountTask *counts;
+    int numCounts;
+    HashMap *result;
+    // Whether the merge runs on a thread of its own.
+    int started;
+};
+
+// Collects output and writes it to the file in large blocks.
+struct OutputBuffer {
+    FILE *file;
+    size_t used;
+    char data[OUTPUT_BUFFER_SIZE];
+};
+
+/**
+ * Estimates the number of distinct words in the given number of bytes of
+ * text with Heaps' law, K * sqrt(n) for n words. The square root is rounded
+ * up to a power of two, which is as fine as table capacities go anyway.
+ * @param bytes
+ * @return Estimated number of distinct words.
+ */
+static int estimateDistinctWords(long bytes) {
+    long words = bytes / BYTES_PER_WORD;
+    long root = 1;
+    while (root * root < words) {
+        root *= 2;
+    }
+    long distinct = HEAPS_CONSTANT * root;
+    return (int) (distinct < words ? distinct : words);
+}
+
+/**
+ * Returns 1 if the character is part of a word, using the same rules as
+ * nextWord.
+ * @param c
+ * @return 1 for digits, letters and apostrophes, 0 otherwise.
+ */
+static int isWordChar(char c) {
+    return (c >= '0' && c <= '9') ||
+           (c >= 'A' && c <= 'Z') ||
+           (c >= 'a' && c <= 'z') ||
+           c == '\'';
+}
+
+/**
+ * Counts the words of a chunk, lowercased as nextWord does, into the map of
+ * the partition each word belongs to.
+ * @param argument The CountTask.
+ * @return NULL.
+ */
+static void *countChunk(void *argument) {
+    CountTask *task = argument;
+    int maxLength = 64;
+    char *word = malloc(sizeof(char) * maxLength);
+    const char *cursor = task->start;
+    while (cursor < task->end) {
+        while (cursor < task->end && !isWordChar(*cursor)) {
+            cursor++;
+        }
+        int length = 0;
+        while (cursor < task->end && isWordChar(*cursor)) {
+            if (length + 1 >= maxLength) {
+                maxLength *= 2;
+                word = realloc(word, maxLength);
+            }
+            word[length++] = (char) tolower(*cursor++);
+        }
+        if (length > 0) {
+            word[length] = '\0';
+            unsigned int partition = DEFAULT_HASH_FUNCTION(word, PARTITION_SEED) % task->numPartitions;
+            (*hashMapGetOrInsert(task->partitions[partition], word, 0))++;
+        }
+    }
+    free(word);
+    return NULL;
+}
+
+/**
+ * Adds up one partition's counts from every chunk, freeing the chunk maps as
+ * it goes. No other thread touches the partition's maps.
+ * @param argument The MergeTask.
+ * @return NULL.
+ */
+static void *mergePartition(void *argument) {
+    MergeTask *task = argument;
+    task->result = task->counts[0].partitions[task->partition];
+    for (int i = 1; i < task->numCounts; i++) {
+        HashMap *partial = task->counts[i].partitions[task->partition];
+        HashMapIterator iterator;
+        hashMapIteratorInit(&iterator, partial);
+        const char *key;
+        int *value;
+        while (hashMapIteratorNext(&iterator, &key, &value)) {
+            *hashMapGetOrInsert(task->result, key, 0) += *value;
+        }
+        hashMapDelete(partial);
+    }
+    return NULL;
+}
+
+/**
+ * Counts the words of a file with several threads. The file is mapped and
+ * cut into one chunk per thread at word boundaries. Each thread counts its
+ * chunk into thread-local maps, one per partition of the words by hash, so
+ * the partial counts of a word always land in the same partition. The
+ * partitions are then merged in parallel, one thread per partition with no
+ * sharing, and finally gathered into one map that borrows the merged
+ * partitions' keys instead of copying them.
+ * @param fileName
+ * @param numThreads At most MAX_COUNT_THREADS.
+ * @param partitions Array of numThreads maps, filled with the merged
+ * partitions. The returned map points into their keys, so they are deleted
+ * after it.
+ * @return The map of word counts, or NULL if the file could not be mapped or
+ * the threads could not be started.
+ */
+HashMap *countWordsParallel(const char *fileName, int numThreads, HashMap **partitions) {
+    assert(numThreads > 0 && numThreads <= MAX_COUNT_THREADS);
+    MappedFile *file = mappedFileOpen(fileName, 0);
+    if (file == NULL) {
+        return NULL;
+    }
+
+    CountTask *counts = malloc(sizeof(CountTask) * numThreads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * numThreads);
+    const char *end = file->data + file->length;
+    const char *start = file->data;
+    for (int i = 0; i < numThreads; i++) {
+        const char *chunkEnd = i == numThreads - 1 ? end : file->data + file->length / numThreads * (i + 1);
+        if (chunkEnd < start) {
+            chunkEnd = start;
+        }
+        // Move the cut past the end of any word it would split
+        while (chunkEnd < end && chunkEnd > file->data && isWordChar(chunkEnd[-1])) {
+            chunkEnd++;
+        }
+        counts[i].start = start;
+        counts[i].end = chunkEnd;
+        counts[i].numPartitions = numThreads;
+        counts[i].partitions = malloc(sizeof(HashMap *) * numThreads);
+        int partitionSize = estimateDistinctWords(chunkEnd - start) / numThreads;
+        for (int p = 0; p < numThreads; p++) {
+            counts[i].partitions[p] = hashMapNew(1);
+            hashMapUseArena(counts[i].partitions[p]);
+            hashMapReserve(counts[i].partitions[p], partitionSize);
+        }
+        start = chunkEnd;
+    }
+    int numStarted = 0;
+    while (numStarted < numThreads &&
+           pthread_create(&threads[numStarted], NULL, countChunk, &counts[numStarted]) == 0) {
+        numStarted++;
+    }
+    for (int i = 0; i < numStarted; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    if (numStarted < numThreads) {
+        // Give up and let the caller count on one thread
+        for (int i = 0; i < numThreads; i++) {
+            for (int p = 0; p < numThreads; p++) {
+                hashMapDelete(counts[i].partitions[p]);
+            }
+            free(counts[i].partitions);
+        }
+        free(counts);
+        free(threads);
+        mappedFileClose(file);
+        return NULL;
+    }
+
+    MergeTask *merges = malloc(sizeof(MergeTask) * numThreads);
+    for (int p = 0; p < numThreads; p++) {
+        merges[p].partition = p;
+        merges[p].counts = counts;
+        merges[p].numCounts = numThreads;
+        merges[p].started = pthread_create(&threads[p], NULL, mergePartition, &merges[p]) == 0;
+        if (!merges[p].started) {
+            // Merge this partition on this thread instead
+            mergePartition(&merges[p]);
+        }
+    }
+    for (int p = 0; p < numThreads; p++) {
+        if (merges[p].started) {
+            pthread_join(threads[p], NULL);
+        }
+    }
+
+    // The partitions hold disjoint words, so gathering them is one insert
+    // per distinct word into a map sized for all of them, without copying
+    // any key
+    int numWords = 0;
+    for (int p = 0; p < numThreads; p++) {
+        numWords += hashMapSize(merges[p].result);
+    }
+    HashMap *map = hashMapNew(1);
+    hashMapUseArena(map);
+    hashMapReserve(map, numWords);
+    for (int p = 0; p < numThreads; p++) {
+        HashMapIterator iterator;
+        hashMapIteratorInit(&iterator, merges[p].result);
+        const char *key;
+        int *value;
+        while (hashMapIteratorNext(&iterator, &key, &value)) {
+            hashMapPutBorrowed(map, key, *value);
+        }
+        partitions[p] = merges[p].result;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        free(counts[i].partitions);
+    }
+    free(merges);
+    free(counts);
+    free(threads);
+    mappedFileClose(file);
+    return map;
+}
+
+/**
+ * Appends a string to the buffer, writing the buffer out when it fills.
+ * @param output
+ * @param string
+ * @param length
+ */
+static void outputWrite(OutputBuffer *output, const char *string, size_t length) {
+    if (output->used + length > OUTPUT_BUFFER_SIZE) {
+        fwrite(output->data, 1, output->used, output->file);
+        output->used = 0;
+        if (length > OUTPUT_BUFFER_SIZE) {
+            fwrite(string, 1, length, output->file);
+            return;
+        }
+    }
+    memcpy(output->data + output->used, string, length);
+    output->used += length;
+}
+
+/**
+ * Writes the entries one per line as the word, a tab and the count, through
+ * a buffer rather than a printf per line.
+ * @param entries
+ * @param size
+ * @param file
+ */
+void writeCounts(WordCount *entries, int size, FILE *file) {
+    OutputBuffer *output = malloc(sizeof(OutputBuffer));
+    output->file = file;
+    output->used = 0;
+    char number[16];
+    for (int i = 0; i < size; i++) {
+        outputWrite(output, entries[i].word, strlen(entries[i].word));
+        // Format the count backwards from the end of the buffer
+        char *digit = number + sizeof(number);
+        *--digit = '\n';
+        unsigned int count = (unsigned int) entries[i].count;
+        do {
+            *--digit = (char) ('0' + count % 10);
+            count /= 10;
+        } while (count > 0);
+        *--digit = '\t';
+        outputWrite(output, digit, number + sizeof(number) - digit);
+    }
+    fwrite(output->data, 1, output->used, file);
+    fflush(file);
+    free(output);
+}
+
 /**
  * Prints the concordance of the given file and performance information. Uses
  * the file input1.txt by default or a file name specified as a command line
- * argument.
+ * argument. A second argument sets the number of threads to count with. The
+ * whole table is printed unless one of these options is given:
+ *   --top N    print the N most frequent words, most frequent first
+ *   --sorted   print every word, most frequent first
  * @param argc
  * @param argv
  * @return
  */
 int main(int argc, const char **argv) {
     const char *fileName = "input1.txt";
-    if (argc > 1) {
-        fileName = argv[1];
+    int numThreads = 1;
+    int topN = 0;
+    int sorted = 0;
+    int numPositional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            topN = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sorted") == 0) {
+            sorted = 1;
+        } else if (numPositional++ == 0) {
+            fileName = argv[i];
+        } else {
+            numThreads = atoi(argv[i]);
+        }
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    } else if (numThreads > MAX_COUNT_THREADS) {
+        numThreads = MAX_COUNT_THREADS;
     }
     printf("Opening file: %s\n", fileName);
-    FILE *inputFile = fopen(fileName, "r");
-    if (inputFile != NULL) {
-        clock_t timer = clock();
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-        HashMap *map = hashMapNew(10);
+    // Maps the parallel count's map borrows its keys from
+    HashMap *partitions[MAX_COUNT_THREADS];
+    HashMap *map = numThreads > 1 ? countWordsParallel(fileName, numThreads, partitions) : NULL;
+    if (map == NULL) {
+        numThreads = 1;
+        FILE *inputFile = fopen(fileName, "r");
+        if (inputFile == NULL) {
+            printf("There was an error opening the file.");
+            return 0;
+        }
+
+        map = hashMapNew(1);
+        hashMapUseArena(map);
+        if (fseek(inputFile, 0, SEEK_END) == 0) {
+            hashMapReserve(map, estimateDistinctWords(ftell(inputFile)));
+            rewind(inputFile);
+        }
 
         // --- Concordance code begins here ---
 
+        // Count the words a batch at a time
+        char *words[HASH_MAP_BATCH];
+        int numWords = 0;
         char *word = nextWord(inputFile);
-        int *value;
         while (word != NULL) {
-            value = hashMapGet(map, word);
-            if (value != NULL) {
-                hashMapPut(map, word, *value + 1);
-            } else {
-                hashMapPut(map, word, 1);
-            }
-            free(word);
+            words[numWords++] = word;
             word = nextWord(inputFile);
+            if (numWords == HASH_MAP_BATCH || word == NULL) {
+                hashMapAddAll(map, (const char **) words, numWords, 1);
+                for (int i = 0; i < numWords; i++) {
+                    free(words[i]);
+                }
+                numWords = 0;
+            }
         }
 
         // --- Concordance code ends here ---
 
         // Close the file
         fclose(inputFile);
+    }
 
+    if (topN > 0 || sorted) {
+        fflush(stdout);
+        WordCount *entries = extractCounts(map);
+        int size = hashMapSize(map);
+        if (topN > 0) {
+            size = selectTopCounts(entries, size, topN);
+        } else {
+            radixSortCounts(entries, size);
+        }
+        writeCounts(entries, size, stdout);
+        free(entries);
+    } else {
         hashMapPrint(map);
+    }
 
-        timer = clock() - timer;
-        printf("\nRan in %f seconds\n", (float) timer / (float) CLOCKS_PER_SEC);
-        printf("Empty buckets: %d\n", hashMapEmptyBuckets(map));
-        printf("Number of links: %d\n", hashMapSize(map));
-        printf("Number of buckets: %d\n", hashMapCapacity(map));
-        printf("Table load: %f\n", hashMapTableLoad(map));
-
-        hashMapDelete(map);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("\nRan in %f seconds", (float) (end.tv_sec - start.tv_sec) +
+           (float) (end.tv_nsec - start.tv_nsec) / 1e9f);
+    if (numThreads > 1) {
+        printf(" on %d threads\n", numThreads);
     } else {
-        printf("There was an error opening the file.");
+        printf("\n");
     }
+    printf("Empty buckets: %d\n", hashMapEmptyBuckets(map));
+    printf("Number of links: %d\n", hashMapSize(map));
+    printf("Number of buckets: %d\n", hashMapCapacity(map));
+    printf("Table load: %f\n", hashMapTableLoad(map));
 
+    hashMapDelete(map);
+    for (int p = 0; p < numThreads && numThreads > 1; p++) {
+        hashMapDelete(partitions[p]);
+    }
     return 0;
-}
\ No newline at end of file
+}
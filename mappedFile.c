@@ -0,0 +1,73 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mappedFile.h"
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Maps the whole of an open file into memory. A writable mapping is private,
+ * so changes are never written back to the file.
+ * @param descriptor Open file descriptor, which stays open.
+ * @param writable 1 to allow the mapped bytes to be modified.
+ * @return The mapped file, or NULL if it could not be mapped.
+ */
+MappedFile *mappedFileMap(int descriptor, int writable) {
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        return NULL;
+    }
+
+    MappedFile *file = malloc(sizeof(MappedFile));
+    file->length = (size_t) status.st_size;
+    file->data = NULL;
+    if (file->length > 0) {
+        int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *data = mmap(NULL, file->length, protection, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED) {
+            free(file);
+            return NULL;
+        }
+        file->data = data;
+    }
+    return file;
+}
+
+/**
+ * Maps a whole file into memory. A writable mapping is private, so changes
+ * are never written back to the file.
+ * @param fileName
+ * @param writable 1 to allow the mapped bytes to be modified.
+ * @return The mapped file, or NULL if it could not be opened or mapped.
+ */
+MappedFile *mappedFileOpen(const char *fileName, int writable) {
+    int descriptor = open(fileName, O_RDONLY);
+    if (descriptor < 0) {
+        return NULL;
+    }
+    MappedFile *file = mappedFileMap(descriptor, writable);
+    // The mapping stays valid after the descriptor is closed
+    close(descriptor);
+    return file;
+}
+
+/**
+ * Unmaps the file and frees the structure.
+ * @param file
+ */
+void mappedFileClose(MappedFile *file) {
+    if (file == NULL) {
+        return;
+    }
+    if (file->data != NULL) {
+        munmap(file->data, file->length);
+    }
+    free(file);
+}
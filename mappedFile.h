@@ -0,0 +1,24 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <stddef.h>
+
+typedef struct MappedFile MappedFile;
+
+struct MappedFile
+{
+    char* data;
+    // Length of the file in bytes.
+    size_t length;
+};
+
+MappedFile* mappedFileMap(int descriptor, int writable);
+MappedFile* mappedFileOpen(const char* fileName, int writable);
+void mappedFileClose(MappedFile* file);
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ringQueue.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+// Times ringQueuePush and ringQueuePop retry before going to sleep.
+#define RING_QUEUE_SPINS 128
+
+/**
+ * Creates an empty queue.
+ * @param capacity Number of items the queue holds, rounded up to a power of
+ * two.
+ * @return The allocated queue.
+ */
+RingQueue *ringQueueNew(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    RingQueue *queue = malloc(sizeof(RingQueue));
+    queue->cells = malloc(sizeof(RingCell) * size);
+    for (size_t i = 0; i < size; i++) {
+        queue->cells[i].sequence = i;
+        queue->cells[i].item = NULL;
+    }
+    queue->mask = size - 1;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->waitingPushes = 0;
+    queue->waitingPops = 0;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+    return queue;
+}
+
+/**
+ * Frees the queue. Items still in it are not freed.
+ * @param queue
+ */
+void ringQueueDelete(RingQueue *queue) {
+    assert(queue != NULL);
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->notFull);
+    pthread_cond_destroy(&queue->notEmpty);
+    free(queue->cells);
+    free(queue);
+}
+
+/**
+ * Wakes the threads asleep on a condition, if there are any. The fence pairs
+ * with the one a thread makes between counting itself as waiting and trying
+ * the queue a last time, so either that try sees this thread's push or pop,
+ * or this thread sees the waiter.
+ * @param queue
+ * @param waiting Number of threads asleep on the condition.
+ * @param condition
+ */
+static void wakeWaiting(RingQueue *queue, int *waiting, pthread_cond_t *condition) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_broadcast(condition);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+/**
+ * Adds an item at the back of the queue unless it is full, without waking
+ * anyone.
+ * @param queue
+ * @param item
+ * @return 1 if the item was added, 0 if the queue was full.
+ */
+static int tryPush(RingQueue *queue, void *item) {
+    size_t position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    while (1) {
+        RingCell *cell = &queue->cells[position & queue->mask];
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+        if (difference == 0) {
+            // The cell is free on this lap; claim it
+            if (__atomic_compare_exchange_n(&queue->head, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->item = item;
+                __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (difference < 0) {
+            // The cell still holds an item from the previous lap
+            return 0;
+        } else {
+            position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * Removes the item at the front of the queue unless it is empty, without
+ * waking anyone.
+ * @param queue
+ * @param item Set to the removed item.
+ * @return 1 if an item was removed, 0 if the queue was empty.
+ */
+static int tryPop(RingQueue *queue, void **item) {
+    size_t position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    while (1) {
+        RingCell *cell = &queue->cells[position & queue->mask];
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&queue->tail, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *item = cell->item;
+                // Hand the cell back to pushes on the next lap
+                __atomic_store_n(&cell->sequence, position + queue->mask + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (difference < 0) {
+            return 0;
+        } else {
+            position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * Adds an item at the back of the queue unless it is full.
+ * @param queue
+ * @param item
+ * @return 1 if the item was added, 0 if the queue was full.
+ */
+int ringQueueTryPush(RingQueue *queue, void *item) {
+    if (!tryPush(queue, item)) {
+        return 0;
+    }
+    wakeWaiting(queue, &queue->waitingPops, &queue->notEmpty);
+    return 1;
+}
+
+/**
+ * Removes the item at the front of the queue unless it is empty.
+ * @param queue
+ * @param item Set to the removed item.
+ * @return 1 if an item was removed, 0 if the queue was empty.
+ */
+int ringQueueTryPop(RingQueue *queue, void **item) {
+    if (!tryPop(queue, item)) {
+        return 0;
+    }
+    wakeWaiting(queue, &queue->waitingPushes, &queue->notFull);
+    return 1;
+}
+
+/**
+ * Adds an item at the back of the queue. While the queue is full, retries a
+ * few times and then sleeps until a pop makes room.
+ * @param queue
+ * @param item
+ */
+void ringQueuePush(RingQueue *queue, void *item) {
+    for (int spin = 0; spin < RING_QUEUE_SPINS; spin++) {
+        if (ringQueueTryPush(queue, item)) {
+            return;
+        }
+    }
+    pthread_mutex_lock(&queue->lock);
+    __atomic_add_fetch(&queue->waitingPushes, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!tryPush(queue, item)) {
+        pthread_cond_wait(&queue->notFull, &queue->lock);
+    }
+    __atomic_sub_fetch(&queue->waitingPushes, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&queue->lock);
+    wakeWaiting(queue, &queue->waitingPops, &queue->notEmpty);
+}
+
+/**
+ * Removes the item at the front of the queue. While the queue is empty,
+ * retries a few times and then sleeps until a push brings an item.
+ * @param queue
+ * @return The removed item.
+ */
+void *ringQueuePop(RingQueue *queue) {
+    void *item;
+    for (int spin = 0; spin < RING_QUEUE_SPINS; spin++) {
+        if (ringQueueTryPop(queue, &item)) {
+            return item;
+        }
+    }
+    pthread_mutex_lock(&queue->lock);
+    __atomic_add_fetch(&queue->waitingPops, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!tryPop(queue, &item)) {
+        pthread_cond_wait(&queue->notEmpty, &queue->lock);
+    }
+    __atomic_sub_fetch(&queue->waitingPops, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&queue->lock);
+    wakeWaiting(queue, &queue->waitingPushes, &queue->notFull);
+    return item;
+}
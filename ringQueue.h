@@ -0,0 +1,64 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+
+/*
+ * Bounded lock-free queue of pointers that any number of threads may push to
+ * and pop from (Vyukov's bounded MPMC queue). Every cell carries a sequence
+ * number telling whether it is ready to be written or read on the current lap
+ * around the ring, so a push or pop is one compare-and-swap on the head or
+ * tail and never takes a lock. NULL is a valid item.
+ *
+ * ringQueuePush and ringQueuePop retry a full or empty queue a few times and
+ * then sleep on a condition variable until a pop or push wakes them. Pushes
+ * and pops only touch the lock when a thread is asleep.
+ */
+
+#define CACHE_LINE_SIZE 64
+
+typedef struct RingQueue RingQueue;
+typedef struct RingCell RingCell;
+
+struct RingCell
+{
+    size_t sequence;
+    void* item;
+};
+
+struct RingQueue
+{
+    RingCell* cells;
+    // Capacity - 1; the capacity is a power of two.
+    size_t mask;
+    // Head and tail are written by different threads, so each gets its own
+    // cache line.
+    char padding0[CACHE_LINE_SIZE];
+    // Position of the next push.
+    size_t head;
+    char padding1[CACHE_LINE_SIZE];
+    // Position of the next pop.
+    size_t tail;
+    char padding2[CACHE_LINE_SIZE];
+    // Threads asleep in ringQueuePush and ringQueuePop, and what they sleep on.
+    int waitingPushes;
+    int waitingPops;
+    pthread_mutex_t lock;
+    pthread_cond_t notFull;
+    pthread_cond_t notEmpty;
+};
+
+RingQueue* ringQueueNew(size_t capacity);
+void ringQueueDelete(RingQueue* queue);
+int ringQueueTryPush(RingQueue* queue, void* item);
+int ringQueueTryPop(RingQueue* queue, void** item);
+void ringQueuePush(RingQueue* queue, void* item);
+void* ringQueuePop(RingQueue* queue);
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "searchPool.h"
+#include <stdlib.h>
+#include <assert.h>
+
+/**
+ * Searches the worker's partition for the current query.
+ * @param worker
+ */
+static void searchPart(SearchWorker *worker) {
+    SearchPool *pool = worker->pool;
+    worker->count = wordBatchSearchPart(pool->batch, pool->query, worker->suggestions,
+                                        pool->numSuggestions, pool->metric, worker->part,
+                                        pool->numThreads);
+}
+
+/**
+ * Body of each worker thread: waits for a search, runs it on its partition
+ * and reports back, until the pool is deleted.
+ * @param argument The worker.
+ * @return NULL.
+ */
+static void *workerMain(void *argument) {
+    SearchWorker *worker = argument;
+    SearchPool *pool = worker->pool;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->started, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        searchPart(worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * Grows every worker's suggestions to hold at least the given number.
+ * @param pool
+ * @param numSuggestions
+ */
+static void reserveSuggestions(SearchPool *pool, int numSuggestions) {
+    if (numSuggestions <= pool->maxSuggestions) {
+        return;
+    }
+    for (int i = 0; i < pool->numThreads; i++) {
+        free(pool->workers[i].suggestions);
+        pool->workers[i].suggestions = malloc(sizeof(Suggestion) * numSuggestions);
+    }
+    pool->maxSuggestions = numSuggestions;
+}
+
+/**
+ * Creates a pool that searches the given batch with the given number of
+ * threads, counting the caller. The batch must outlive the pool.
+ * @param batch
+ * @param numThreads At least 1.
+ * @return The allocated pool, or NULL if the threads could not be started.
+ */
+SearchPool *searchPoolNew(WordBatch *batch, int numThreads) {
+    assert(batch != NULL);
+    assert(numThreads >= 1);
+    SearchPool *pool = malloc(sizeof(SearchPool));
+    pool->batch = batch;
+    pool->numThreads = numThreads;
+    pool->workers = malloc(sizeof(SearchWorker) * numThreads);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->started, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->quit = 0;
+    pool->query = NULL;
+    pool->numSuggestions = 0;
+    pool->maxSuggestions = 0;
+    for (int i = 0; i < numThreads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].part = i;
+        pool->workers[i].suggestions = NULL;
+        pool->workers[i].count = 0;
+    }
+    for (int i = 1; i < numThreads; i++) {
+        if (pthread_create(&pool->workers[i].thread, NULL, workerMain, &pool->workers[i]) != 0) {
+            // Stop the workers started so far.
+            pool->numThreads = i;
+            searchPoolDelete(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/**
+ * Stops the workers and frees the pool. The batch is not freed.
+ * @param pool
+ */
+void searchPoolDelete(SearchPool *pool) {
+    assert(pool != NULL);
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->started);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->numThreads; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    for (int i = 0; i < pool->numThreads; i++) {
+        free(pool->workers[i].suggestions);
+    }
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->started);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+ * Finds the words closest to the query, every thread scanning its own
+ * partition of the batch. Searches must not be run on the same pool from
+ * more than one thread at a time.
+ * @param pool
+ * @param query
+ * @param suggestions Filled with the closest words, nearest first.
+ * @param numSuggestions Number of words wanted.
+ * @param metric Distance to rank the words by, one of the METRIC_ constants.
+ * @return Number of suggestions found.
+ */
+int searchPoolSearch(SearchPool *pool, const char *query, Suggestion *suggestions,
+                     int numSuggestions, int metric) {
+    assert(pool != NULL);
+    assert(query != NULL);
+    reserveSuggestions(pool, numSuggestions);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->query = query;
+    pool->numSuggestions = numSuggestions;
+    pool->metric = metric;
+    pool->pending = pool->numThreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->started);
+    pthread_mutex_unlock(&pool->lock);
+
+    searchPart(&pool->workers[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    TopK topK;
+    topKInit(&topK, suggestions, numSuggestions);
+    for (int i = 0; i < pool->numThreads; i++) {
+        SearchWorker *worker = &pool->workers[i];
+        for (int j = 0; j < worker->count; j++) {
+            Suggestion *found = &worker->suggestions[j];
+            topKOffer(&topK, found->word, found->distance, found->frequency);
+        }
+    }
+    return topKFinish(&topK);
+}
@@ -0,0 +1,65 @@
+#ifndef SEARCH_POOL_H
+#define SEARCH_POOL_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <pthread.h>
+#include "levenshteinBatch.h"
+#include "suggestion.h"
+
+/*
+ * Pool of worker threads that scan a word batch together. Each search splits
+ * the batch into one interleaved partition per thread (see
+ * wordBatchSearchPart); every thread keeps its own suggestions for its
+ * partition, and the caller merges them once all have finished. The calling
+ * thread searches the first partition itself, so a pool of n threads starts
+ * n - 1 workers.
+ */
+
+typedef struct SearchPool SearchPool;
+typedef struct SearchWorker SearchWorker;
+
+struct SearchWorker
+{
+    SearchPool* pool;
+    pthread_t thread;
+    // Partition this worker searches.
+    int part;
+    // Suggestions found in the partition by the last search.
+    Suggestion* suggestions;
+    int count;
+};
+
+struct SearchPool
+{
+    // Read by every thread, never modified while the pool exists.
+    WordBatch* batch;
+    int numThreads;
+    // numThreads entries; the first belongs to the calling thread.
+    SearchWorker* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t started;
+    pthread_cond_t finished;
+    // Incremented for every search so the workers can tell a new one apart
+    // from a spurious wake-up.
+    unsigned long generation;
+    // Number of workers still searching.
+    int pending;
+    int quit;
+    // Current search.
+    const char* query;
+    int numSuggestions;
+    int metric;
+    // Capacity of each worker's suggestions.
+    int maxSuggestions;
+};
+
+SearchPool* searchPoolNew(WordBatch* batch, int numThreads);
+void searchPoolDelete(SearchPool* pool);
+int searchPoolSearch(SearchPool* pool, const char* query, Suggestion* suggestions,
+                     int numSuggestions, int metric);
+
+#endif
@@ -1,14 +1,88 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "hashMap.h"
+#include "mappedFile.h"
+#include "dictSnapshot.h"
+#include "levenshtein.h"
+#include "bkTree.h"
+#include "wordTrie.h"
+#include "levenshteinBatch.h"
+#include "searchPool.h"
+#include "documentCheck.h"
+#include "suggestionCache.h"
+#include "suggestionStore.h"
 #include <assert.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 
-#define MIN3(a, b, c) ((a) < (b) ? ((a) < (c) ? (a) : (c)) : ((b) < (c) ? (b) : (c)))
 const int NUM_SUGGESTIONS = 5;
 
+// Number of misspelled words whose suggestions are cached unless --cache
+// says otherwise.
+#define SUGGESTION_CACHE_SIZE 4096
+
+// Bytes per word assumed when sizing the map from the size of a word list,
+// newline included. A little under the average of dictionary.txt, so the
+// estimate errs on the large side and loading never grows the table.
+#define DICTIONARY_BYTES_PER_WORD 8
+
+typedef struct Dictionary Dictionary;
+typedef struct DictionaryIterator DictionaryIterator;
+typedef struct CheckOutput CheckOutput;
+
+// The loaded dictionary: either a hash map built from the word list, or a
+// snapshot saved from one. Each word's value is how common it is, or -1 if
+// that is not known.
+struct Dictionary
+{
+    HashMap* map;
+    // Mapped word list the map's keys point into, if any.
+    MappedFile* file;
+    DictSnapshot* snapshot;
+    // Structure suggestions are searched in: a trie over the words, a
+    // BK-tree index, or the words grouped for scanning; the others are NULL.
+    WordTrie* trie;
+    BkTree* index;
+    WordBatch* batch;
+    // Threads scanning the batch together, or NULL to scan on this thread.
+    SearchPool* pool;
+    // Suggestions already found, or NULL to always search.
+    SuggestionCache* cache;
+    // Suggestions found by earlier runs, or NULL if they are not kept.
+    SuggestionStore* store;
+    // When searches may stop early, passed on to the trie, index or batch;
+    // stopDistance is -1 when they never do.
+    int stopDistance;
+    int stopFrequency;
+    // Distance suggestions are ranked by, one of the METRIC_ constants.
+    int metric;
+};
+
+struct DictionaryIterator
+{
+    Dictionary* dictionary;
+    HashMapIterator mapIterator;
+    const char* key;
+};
+
+// Output formats of the batch check.
+enum { FORMAT_TSV, FORMAT_JSONL };
+
+// How suggestions are searched for, see dictionaryBuildIndex.
+enum { SEARCH_BK_TREE, SEARCH_SCAN, SEARCH_TRIE };
+
+// Context of the batch check callbacks.
+struct CheckOutput
+{
+    Dictionary* dictionary;
+    FILE* output;
+    int format;
+};
+
 /**
  * Allocates a string for the next word in the file and returns it. This string
  * is null terminated. Returns NULL after reaching the end of the file.
@@ -60,6 +134,18 @@ void loadDictionary(FILE* file, HashMap* map)
     assert(file != NULL);
     assert(map != NULL);
 
+    // Size the map for the rest of the file up front
+    long position = ftell(file);
+    if (position >= 0 && fseek(file, 0, SEEK_END) == 0)
+    {
+        long length = ftell(file);
+        if (length > position)
+        {
+            hashMapReserve(map, (int) ((length - position) / DICTIONARY_BYTES_PER_WORD));
+        }
+        fseek(file, position, SEEK_SET);
+    }
+
     // Load the words into the dictionary
     char *word = nextWord(file);
     while (word != NULL) {
@@ -69,6 +155,443 @@ void loadDictionary(FILE* file, HashMap* map)
     }
 }
 
+/**
+ * Returns 1 if the character is part of a word, using the same rules as
+ * nextWord.
+ * @param c
+ * @return 1 for digits, letters and apostrophes, 0 otherwise.
+ */
+static int isWordChar(char c)
+{
+    return (c >= '0' && c <= '9') ||
+           (c >= 'A' && c <= 'Z') ||
+           (c >= 'a' && c <= 'z') ||
+           c == '\'';
+}
+
+/**
+ * Maps the dictionary file into memory and loads its words into the hash map
+ * without copying them. Each word is lowercased and null terminated in place,
+ * in the private mapping, and the map borrows a pointer to it, so the map
+ * must be arena-backed and the returned file must stay mapped for as long as
+ * the map is used. A last word running up to the end of the file has no byte
+ * left for its terminator and is copied instead.
+ * @param fileName
+ * @param map
+ * @return The mapped file to close after deleting the map, or NULL if the
+ * file could not be mapped.
+ */
+MappedFile* loadDictionaryMapped(const char* fileName, HashMap* map)
+{
+    assert(fileName != NULL);
+    assert(map != NULL);
+
+    MappedFile* file = mappedFileOpen(fileName, 1);
+    if (file == NULL)
+    {
+        return NULL;
+    }
+    hashMapReserve(map, (int) (file->length / DICTIONARY_BYTES_PER_WORD));
+    char* cursor = file->data;
+    char* end = file->data + file->length;
+    while (cursor < end)
+    {
+        // Skip to the start of the next word
+        while (cursor < end && !isWordChar(*cursor))
+        {
+            cursor++;
+        }
+        char* word = cursor;
+        while (cursor < end && isWordChar(*cursor))
+        {
+            *cursor = (char) tolower(*cursor);
+            cursor++;
+        }
+        if (cursor == word)
+        {
+            break;
+        }
+        if (cursor < end)
+        {
+            // Terminate the word over the separator that ended it
+            *cursor = '\0';
+            cursor++;
+            hashMapPutBorrowed(map, word, -1);
+        }
+        else
+        {
+            // On the heap, since the word can be as long as the whole file
+            size_t length = (size_t) (cursor - word);
+            char* last = malloc(length + 1);
+            memcpy(last, word, length);
+            last[length] = '\0';
+            hashMapPut(map, last, -1);
+            free(last);
+        }
+    }
+    return file;
+}
+
+/**
+ * Loads the word list into a new hash map, mapping the file if possible.
+ * @param dictionary
+ * @param fileName
+ * @return 1 on success, 0 if the file could not be opened.
+ */
+int dictionaryLoadWords(Dictionary* dictionary, const char* fileName)
+{
+    // The loaders size the map from the file
+    dictionary->map = hashMapNew(1);
+    hashMapUseArena(dictionary->map);
+    dictionary->snapshot = NULL;
+    dictionary->index = NULL;
+    dictionary->trie = NULL;
+    dictionary->batch = NULL;
+    dictionary->pool = NULL;
+    dictionary->cache = NULL;
+    dictionary->store = NULL;
+    dictionary->stopDistance = -1;
+    dictionary->stopFrequency = 0;
+    dictionary->metric = METRIC_LEVENSHTEIN;
+    dictionary->file = loadDictionaryMapped(fileName, dictionary->map);
+    if (dictionary->file == NULL)
+    {
+        // Fall back to reading the file a word at a time
+        FILE* file = fopen(fileName, "r");
+        if (file == NULL)
+        {
+            hashMapDelete(dictionary->map);
+            return 0;
+        }
+        loadDictionary(file, dictionary->map);
+        fclose(file);
+    }
+    return 1;
+}
+
+/**
+ * Opens a dictionary snapshot written with --write-snapshot.
+ * @param dictionary
+ * @param fileName
+ * @return 1 on success, 0 if the snapshot is missing or invalid.
+ */
+int dictionaryLoadSnapshot(Dictionary* dictionary, const char* fileName)
+{
+    dictionary->map = NULL;
+    dictionary->file = NULL;
+    dictionary->index = NULL;
+    dictionary->trie = NULL;
+    dictionary->batch = NULL;
+    dictionary->pool = NULL;
+    dictionary->cache = NULL;
+    dictionary->store = NULL;
+    dictionary->stopDistance = -1;
+    dictionary->stopFrequency = 0;
+    dictionary->metric = METRIC_LEVENSHTEIN;
+    dictionary->snapshot = dictSnapshotOpen(fileName);
+    return dictionary->snapshot != NULL;
+}
+
+/**
+ * Frees the dictionary's map or snapshot and its suggestion structures.
+ * @param dictionary
+ */
+void dictionaryCleanUp(Dictionary* dictionary)
+{
+    if (dictionary->index != NULL)
+    {
+        bkTreeDelete(dictionary->index);
+    }
+    if (dictionary->trie != NULL)
+    {
+        wordTrieDelete(dictionary->trie);
+    }
+    if (dictionary->pool != NULL)
+    {
+        searchPoolDelete(dictionary->pool);
+    }
+    if (dictionary->batch != NULL)
+    {
+        wordBatchDelete(dictionary->batch);
+    }
+    if (dictionary->map != NULL)
+    {
+        hashMapDelete(dictionary->map);
+    }
+    suggestionCacheDelete(dictionary->cache);
+    // The cache may point into the store's mapping, so it goes first
+    suggestionStoreClose(dictionary->store);
+    mappedFileClose(dictionary->file);
+    dictSnapshotClose(dictionary->snapshot);
+}
+
+/**
+ * Reads word counts written by the concordance program with --top or
+ * --sorted, one word, a tab and its count per line, and stores each count as
+ * the frequency of that word in the dictionary. Other lines, such as the
+ * program's status lines, and words not in the dictionary are ignored.
+ * @param dictionary A dictionary loaded from a word list.
+ * @param fileName
+ * @return Number of dictionary words given a frequency, or -1 if the file
+ * could not be opened.
+ */
+int dictionaryLoadFrequencies(Dictionary* dictionary, const char* fileName)
+{
+    assert(dictionary->map != NULL);
+    FILE* file = fopen(fileName, "r");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    int numFound = 0;
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    while (getline(&line, &lineCapacity, file) > 0)
+    {
+        char* tab = strchr(line, '\t');
+        if (tab == NULL || tab == line)
+        {
+            continue;
+        }
+        *tab = '\0';
+        char* end;
+        long count = strtol(tab + 1, &end, 10);
+        if (end == tab + 1 || (*end != '\n' && *end != '\0') || count < 0)
+        {
+            continue;
+        }
+        int* value = hashMapGet(dictionary->map, line);
+        if (value != NULL)
+        {
+            *value = count < INT_MAX ? (int) count : INT_MAX;
+            numFound++;
+        }
+    }
+    free(line);
+    fclose(file);
+    return numFound;
+}
+
+/**
+ * Returns 1 if the word is in the dictionary and 0 otherwise.
+ * @param dictionary
+ * @param word
+ * @return 1 if the word is found, 0 otherwise.
+ */
+int dictionaryContains(Dictionary* dictionary, const char* word)
+{
+    if (dictionary->snapshot != NULL)
+    {
+        return dictSnapshotGet(dictionary->snapshot, word) != NULL;
+    }
+    return hashMapContainsKey(dictionary->map, word);
+}
+
+/**
+ * Starts an iteration over every word in the dictionary.
+ * @param iterator
+ * @param dictionary
+ */
+void dictionaryIteratorInit(DictionaryIterator* iterator, Dictionary* dictionary)
+{
+    iterator->dictionary = dictionary;
+    iterator->key = NULL;
+    if (dictionary->map != NULL)
+    {
+        hashMapIteratorInit(&iterator->mapIterator, dictionary->map);
+    }
+}
+
+/**
+ * Advances the iterator to the next word.
+ * @param iterator
+ * @param word Set to the word.
+ * @param frequency Set to how common the word is, 0 if that is not known.
+ * @return 1 if a word was found, 0 once every word has been visited.
+ */
+int dictionaryIteratorNext(DictionaryIterator* iterator, const char** word, int* frequency)
+{
+    if (iterator->dictionary->snapshot != NULL)
+    {
+        DictSnapshot* snapshot = iterator->dictionary->snapshot;
+        iterator->key = dictSnapshotNextKey(snapshot, iterator->key);
+        if (iterator->key == NULL)
+        {
+            return 0;
+        }
+        *word = iterator->key;
+        int32_t value = *dictSnapshotGet(snapshot, iterator->key);
+        *frequency = value > 0 ? value : 0;
+        return 1;
+    }
+    int* value;
+    if (!hashMapIteratorNext(&iterator->mapIterator, word, &value))
+    {
+        return 0;
+    }
+    *frequency = *value > 0 ? *value : 0;
+    return 1;
+}
+
+/**
+ * Prepares the dictionary for finding suggestions: builds the BK-tree index
+ * or a trie over every word, or groups the words for batch scanning. All of
+ * them point at the dictionary's own copies of the words and rank words at
+ * equal distance by their frequencies. Cached suggestions are dropped, since
+ * they may no longer match the words.
+ * @param dictionary
+ * @param search One of the SEARCH_ constants.
+ * @param numThreads Number of threads to scan with.
+ */
+void dictionaryBuildIndex(Dictionary* dictionary, int search, int numThreads)
+{
+    if (dictionary->cache != NULL)
+    {
+        suggestionCacheClear(dictionary->cache);
+    }
+    DictionaryIterator iterator;
+    dictionaryIteratorInit(&iterator, dictionary);
+    const char* word;
+    int frequency;
+    if (search == SEARCH_BK_TREE)
+    {
+        dictionary->index = bkTreeNew();
+        bkTreeSetEarlyStop(dictionary->index, dictionary->stopDistance, dictionary->stopFrequency);
+        while (dictionaryIteratorNext(&iterator, &word, &frequency))
+        {
+            bkTreeAdd(dictionary->index, word, frequency);
+        }
+        return;
+    }
+    int numWords = 0;
+    int maxWords = 1024;
+    const char** words = malloc(sizeof(char*) * maxWords);
+    int* frequencies = malloc(sizeof(int) * maxWords);
+    while (dictionaryIteratorNext(&iterator, &word, &frequency))
+    {
+        if (numWords == maxWords)
+        {
+            maxWords *= 2;
+            words = realloc(words, sizeof(char*) * maxWords);
+            frequencies = realloc(frequencies, sizeof(int) * maxWords);
+        }
+        words[numWords] = word;
+        frequencies[numWords++] = frequency;
+    }
+    if (search == SEARCH_TRIE)
+    {
+        dictionary->trie = wordTrieNew(words, frequencies, numWords);
+        wordTrieSetEarlyStop(dictionary->trie, dictionary->stopDistance, dictionary->stopFrequency);
+        free(words);
+        free(frequencies);
+        return;
+    }
+    dictionary->batch = wordBatchNew(words, frequencies, numWords);
+    wordBatchSetEarlyStop(dictionary->batch, dictionary->stopDistance, dictionary->stopFrequency);
+    free(words);
+    free(frequencies);
+    if (numThreads > 1)
+    {
+        // Without the workers the scan still works, just on one thread
+        dictionary->pool = searchPoolNew(dictionary->batch, numThreads);
+    }
+}
+
+/**
+ * Searches the dictionary for the words closest to the given word.
+ * @param dictionary
+ * @param word
+ * @param suggestions Filled with the closest words, nearest first.
+ * @param numSuggestions Number of words wanted.
+ * @return Number of suggestions found.
+ */
+static int searchSuggestions(Dictionary* dictionary, const char* word, Suggestion* suggestions,
+                             int numSuggestions)
+{
+    if (dictionary->index != NULL)
+    {
+        return bkTreeSearch(dictionary->index, word, suggestions, numSuggestions, dictionary->metric);
+    }
+    if (dictionary->trie != NULL)
+    {
+        return wordTrieSearch(dictionary->trie, word, suggestions, numSuggestions, dictionary->metric);
+    }
+    if (dictionary->pool != NULL)
+    {
+        return searchPoolSearch(dictionary->pool, word, suggestions, numSuggestions,
+                                dictionary->metric);
+    }
+    return wordBatchSearch(dictionary->batch, word, suggestions, numSuggestions, dictionary->metric);
+}
+
+/**
+ * Finds the dictionary words closest to the given word, from the cache if
+ * the word has been looked up before, or from the store if an earlier run
+ * looked it up. Searched words are added to both.
+ * @param dictionary
+ * @param word
+ * @param suggestions Filled with the closest words, nearest first.
+ * @param numSuggestions Number of words wanted.
+ * @return Number of suggestions found.
+ */
+int dictionarySuggest(Dictionary* dictionary, const char* word, Suggestion* suggestions,
+                      int numSuggestions)
+{
+    int numFound = -1;
+    if (dictionary->cache != NULL)
+    {
+        numFound = suggestionCacheGet(dictionary->cache, word, suggestions, numSuggestions);
+    }
+    if (numFound < 0 && dictionary->store != NULL)
+    {
+        numFound = suggestionStoreGet(dictionary->store, word, suggestions, numSuggestions);
+        if (numFound >= 0 && dictionary->cache != NULL)
+        {
+            suggestionCachePut(dictionary->cache, word, suggestions, numFound);
+        }
+    }
+    if (numFound < 0)
+    {
+        numFound = searchSuggestions(dictionary, word, suggestions, numSuggestions);
+        if (dictionary->cache != NULL)
+        {
+            suggestionCachePut(dictionary->cache, word, suggestions, numFound);
+        }
+        if (dictionary->store != NULL)
+        {
+            suggestionStoreAppend(dictionary->store, word, suggestions, numFound, numSuggestions);
+        }
+    }
+    return numFound;
+}
+
+/**
+ * Fingerprints the dictionary's words, their frequencies, the early stop and
+ * the metric for tagging stored suggestions. The per-word hashes are summed, so the
+ * fingerprint does not depend on the order the words are visited in, and
+ * any added, removed or changed word changes it.
+ * @param dictionary
+ * @return The fingerprint.
+ */
+uint64_t dictionaryFingerprint(Dictionary* dictionary)
+{
+    uint64_t fingerprint = 0;
+    uint64_t numWords = 0;
+    DictionaryIterator iterator;
+    dictionaryIteratorInit(&iterator, dictionary);
+    const char* word;
+    int frequency;
+    while (dictionaryIteratorNext(&iterator, &word, &frequency))
+    {
+        uint64_t hash = checksumUpdate(CHECKSUM_BASIS, word, strlen(word) + 1);
+        fingerprint += checksumUpdate(hash, &frequency, sizeof(frequency));
+        numWords++;
+    }
+    int settings[3] = { dictionary->stopDistance, dictionary->stopFrequency, dictionary->metric };
+    fingerprint = checksumUpdate(fingerprint, settings, sizeof(settings));
+    return checksumUpdate(fingerprint, &numWords, sizeof(numWords));
+}
+
 /**
  * Takes user-entered input and returns a lowercase version. Returns NULL if invalid input.
  * @param input
@@ -98,48 +621,347 @@ char* validateInput(char *input) {
 }
 
 /**
- * Calculates the Levenshtein distance and returns it.
- * Adapted from: https://en.wikibooks.org/wiki/Algorithm_Implementation/Strings/Levenshtein_distance#C
- * @param s1 and s2, two strings to compare
- * @return an int containing the Levenshtein distance.
+ * Writes one misspelled word and its suggestions.
+ * @param output
+ * @param format FORMAT_TSV or FORMAT_JSONL.
+ * @param offset
+ * @param word
+ * @param suggestions
+ * @param numFound
  */
-int computeLevenshtein(char *s1, char *s2) {
-    unsigned int s1len, s2len, x, y, lastdiag, olddiag;
-    s1len = strlen(s1);
-    s2len = strlen(s2);
-    unsigned int column[s1len+1];
-    for (y = 1; y <= s1len; y++)
-        column[y] = y;
-    for (x = 1; x <= s2len; x++) {
-        column[0] = x;
-        for (y = 1, lastdiag = x-1; y <= s1len; y++) {
-            olddiag = column[y];
-            column[y] = MIN3(column[y] + 1, column[y-1] + 1, lastdiag + (s1[y-1] == s2[x-1] ? 0 : 1));
-            lastdiag = olddiag;
+void writeMiss(FILE* output, int format, long offset, const char* word,
+               Suggestion* suggestions, int numFound)
+{
+    // Words only hold digits, letters and apostrophes, so nothing needs escaping
+    if (format == FORMAT_JSONL)
+    {
+        fprintf(output, "{\"offset\":%ld,\"word\":\"%s\",\"suggestions\":[", offset, word);
+        for (int s = 0; s < numFound; s++)
+        {
+            fprintf(output, s == 0 ? "\"%s\"" : ",\"%s\"", suggestions[s].word);
         }
+        fputs("]}\n", output);
     }
-    return(column[s1len]);
+    else
+    {
+        fprintf(output, "%ld\t%s\t", offset, word);
+        for (int s = 0; s < numFound; s++)
+        {
+            fprintf(output, s == 0 ? "%s" : ",%s", suggestions[s].word);
+        }
+        fputc('\n', output);
+    }
+}
+
+/**
+ * Batch check callback: returns 1 if the word is in the dictionary.
+ * @param context The CheckOutput.
+ * @param word
+ * @return 1 if the word is found, 0 otherwise.
+ */
+int checkContains(void* context, const char* word)
+{
+    return dictionaryContains(((CheckOutput*) context)->dictionary, word);
+}
+
+/**
+ * Batch check callback: finds the suggestions for a misspelled word. Safe to
+ * call from several threads as long as the dictionary has no search pool.
+ * @param context The CheckOutput.
+ * @param word
+ * @param suggestions
+ * @param numSuggestions
+ * @return Number of suggestions found.
+ */
+int checkSuggest(void* context, const char* word, Suggestion* suggestions, int numSuggestions)
+{
+    return dictionarySuggest(((CheckOutput*) context)->dictionary, word, suggestions,
+                             numSuggestions);
+}
+
+/**
+ * Batch check callback: writes a misspelled word in the chosen format.
+ * @param context The CheckOutput.
+ * @param offset
+ * @param word
+ * @param suggestions
+ * @param numFound
+ */
+void checkMiss(void* context, long offset, const char* word, Suggestion* suggestions,
+               int numFound)
+{
+    CheckOutput* output = context;
+    writeMiss(output->output, output->format, offset, word, suggestions, numFound);
 }
 
 /**
- * Prints the concordance of the given file and performance information. Uses
- * the file input1.txt by default or a file name specified as a command line
- * argument.
+ * Prints how many suggestion searches the cache and the store answered, if
+ * there are any.
+ * @param dictionary
+ * @param output
+ */
+void printCacheStats(Dictionary* dictionary, FILE* output)
+{
+    SuggestionCache* cache = dictionary->cache;
+    if (cache != NULL && cache->hits + cache->misses > 0)
+    {
+        fprintf(output, "Suggestion cache: %ld hits, %ld misses (%.1f%% hit rate)\n",
+                cache->hits, cache->misses,
+                100.0 * cache->hits / (cache->hits + cache->misses));
+    }
+    SuggestionStore* store = dictionary->store;
+    if (store != NULL)
+    {
+        fprintf(output, "Suggestion store: %ld words loaded, %ld hits, %ld appended\n",
+                store->loaded, store->hits, store->appended);
+    }
+}
+
+/**
+ * Interactive spell checker. Loads dictionary.txt by default; options:
+ *   --dictionary FILE      load a different word list
+ *   --snapshot FILE        load a snapshot instead of a word list
+ *   --write-snapshot FILE  save the loaded word list as a snapshot and exit
+ *   --frequencies FILE     rank suggestions at equal distance by the word
+ *                          counts in FILE, written by the concordance
+ *                          program with --sorted or --top; snapshots keep
+ *                          the frequencies of the word list they were
+ *                          saved from
+ *   --scan                 find suggestions by scanning every word with the
+ *                          batch kernel instead of walking the trie of words
+ *   --bk-tree              find suggestions with a BK-tree index instead of
+ *                          the trie
+ *   --threads N            scan with N threads (implies --scan); with
+ *                          --check, run the check as a pipeline with N
+ *                          suggestion workers
+ *   --suggestions K        suggest the K closest words (5 by default)
+ *   --early-stop D F       stop searching once K words are found within
+ *                          distance D that each have a frequency of at
+ *                          least F, even if closer words remain unseen
+ *   --metric NAME          rank suggestions by levenshtein distance (the
+ *                          default), damerau distance, which counts swapping
+ *                          two adjacent letters as one edit, or keyboard
+ *                          distance, which also charges half an edit for
+ *                          hitting a neighbouring QWERTY key; keyboard
+ *                          distances, including those of --early-stop, are
+ *                          in half edits
+ *   --cache N              remember the suggestions of the N most recently
+ *                          misspelled words (4096 by default, 0 to disable)
+ *   --cache-file FILE      also keep suggestions in FILE for later runs and
+ *                          other processes; the file is emptied when the
+ *                          dictionary changes
+ *   --check FILE           check every word of FILE ("-" for standard input)
+ *                          instead of prompting, writing a line per
+ *                          misspelled word; progress goes to standard error
+ *   --format tsv|jsonl     output of --check: tab-separated offset, word and
+ *                          comma-separated suggestions (the default), or one
+ *                          JSON object per line
  * @param argc
  * @param argv
  * @return
  */
 int main(int argc, const char** argv)
 {
-    HashMap* map = hashMapNew(1000);
-    
-    FILE* file = fopen("dictionary.txt", "r");
+    const char* dictionaryName = "dictionary.txt";
+    const char* snapshotName = NULL;
+    const char* writeSnapshotName = NULL;
+    int search = SEARCH_TRIE;
+    int numThreads = 1;
+    int numSuggestions = NUM_SUGGESTIONS;
+    const char* checkName = NULL;
+    int format = FORMAT_TSV;
+    int cacheSize = SUGGESTION_CACHE_SIZE;
+    const char* storeName = NULL;
+    const char* frequencyName = NULL;
+    int stopDistance = -1;
+    int stopFrequency = 0;
+    int metric = METRIC_LEVENSHTEIN;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--dictionary") == 0 && i + 1 < argc)
+        {
+            dictionaryName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+        {
+            snapshotName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--write-snapshot") == 0 && i + 1 < argc)
+        {
+            writeSnapshotName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--frequencies") == 0 && i + 1 < argc)
+        {
+            frequencyName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--scan") == 0)
+        {
+            search = SEARCH_SCAN;
+        }
+        else if (strcmp(argv[i], "--bk-tree") == 0)
+        {
+            search = SEARCH_BK_TREE;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            numThreads = atoi(argv[++i]);
+            search = SEARCH_SCAN;
+        }
+        else if (strcmp(argv[i], "--suggestions") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            numSuggestions = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--metric") == 0 && i + 1 < argc && editMetricByName(argv[i + 1]) >= 0)
+        {
+            metric = editMetricByName(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--early-stop") == 0 && i + 2 < argc && atoi(argv[i + 1]) >= 0)
+        {
+            stopDistance = atoi(argv[++i]);
+            stopFrequency = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 0)
+        {
+            cacheSize = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cache-file") == 0 && i + 1 < argc)
+        {
+            storeName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc)
+        {
+            checkName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc &&
+                 (strcmp(argv[i + 1], "tsv") == 0 || strcmp(argv[i + 1], "jsonl") == 0))
+        {
+            format = strcmp(argv[++i], "tsv") == 0 ? FORMAT_TSV : FORMAT_JSONL;
+        }
+        else
+        {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // Keep standard output for the results when checking a document
+    FILE* status = checkName != NULL ? stderr : stdout;
+
+    Dictionary dictionary;
     clock_t timer = clock();
-    loadDictionary(file, map);
+    int loaded = snapshotName != NULL ? dictionaryLoadSnapshot(&dictionary, snapshotName)
+                                      : dictionaryLoadWords(&dictionary, dictionaryName);
     timer = clock() - timer;
-    printf("Dictionary loaded in %f seconds\n", (float)timer / (float)CLOCKS_PER_SEC);
-    fclose(file);
-    
+    if (!loaded)
+    {
+        fprintf(status, "There was an error loading the dictionary.\n");
+        return 1;
+    }
+    fprintf(status, "Dictionary loaded in %f seconds\n", (float)timer / (float)CLOCKS_PER_SEC);
+
+    if (frequencyName != NULL)
+    {
+        int numFound = dictionary.map != NULL ? dictionaryLoadFrequencies(&dictionary, frequencyName) : -1;
+        if (numFound < 0)
+        {
+            fprintf(status, dictionary.map != NULL ? "There was an error loading %s\n"
+                                                   : "%s: frequencies need a word list, not a snapshot\n",
+                    frequencyName);
+            dictionaryCleanUp(&dictionary);
+            return 1;
+        }
+        fprintf(status, "Frequencies loaded for %d words\n", numFound);
+    }
+    dictionary.stopDistance = stopDistance;
+    dictionary.stopFrequency = stopFrequency;
+    dictionary.metric = metric;
+
+    if (writeSnapshotName != NULL)
+    {
+        int written = dictionary.map != NULL && dictSnapshotWrite(dictionary.map, writeSnapshotName);
+        printf(written ? "Snapshot written to %s\n" : "There was an error writing %s\n", writeSnapshotName);
+        dictionaryCleanUp(&dictionary);
+        return written ? 0 : 1;
+    }
+
+    if (cacheSize > 0)
+    {
+        dictionary.cache = suggestionCacheNew(cacheSize, numSuggestions);
+    }
+
+    timer = clock();
+    // The check pipeline runs searches side by side, which a search pool
+    // does not allow, so it gets its own threads instead
+    dictionaryBuildIndex(&dictionary, search, checkName != NULL ? 1 : numThreads);
+    timer = clock() - timer;
+    if (search == SEARCH_BK_TREE)
+    {
+        fprintf(status, "Suggestion index built in %f seconds\n", (float)timer / (float)CLOCKS_PER_SEC);
+    }
+    else if (search == SEARCH_TRIE)
+    {
+        fprintf(status, "Suggestion trie of %d nodes built in %f seconds\n",
+                dictionary.trie->numNodes, (float)timer / (float)CLOCKS_PER_SEC);
+    }
+    else
+    {
+        fprintf(status, "Scan prepared in %f seconds using the %s kernel on %d thread(s)\n",
+               (float)timer / (float)CLOCKS_PER_SEC, levenshteinBatchKernelName(),
+               dictionary.pool != NULL || checkName != NULL ? numThreads : 1);
+    }
+
+    if (storeName != NULL)
+    {
+        dictionary.store = suggestionStoreOpen(storeName, dictionaryFingerprint(&dictionary));
+        if (dictionary.store == NULL)
+        {
+            fprintf(status, "There was an error opening %s; suggestions will not be kept\n", storeName);
+        }
+    }
+
+    if (checkName != NULL)
+    {
+        FILE* input = strcmp(checkName, "-") == 0 ? stdin : fopen(checkName, "r");
+        if (input == NULL)
+        {
+            fprintf(stderr, "There was an error opening %s\n", checkName);
+            dictionaryCleanUp(&dictionary);
+            return 1;
+        }
+        static char outputBuffer[1 << 16];
+        setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+        CheckOutput output = { &dictionary, stdout, format };
+        DocumentChecker checker = { &output, checkContains, checkSuggest, checkMiss,
+                                    numSuggestions };
+        CheckStats stats;
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (numThreads > 1)
+        {
+            checkDocumentPipelined(&checker, input, numThreads, &stats);
+        }
+        else
+        {
+            checkDocument(&checker, input, &stats);
+        }
+        fflush(stdout);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (input != stdin)
+        {
+            fclose(input);
+        }
+        float seconds = (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec) / 1e9f;
+        fprintf(stderr, "Checked %ld words (%ld bytes) in %f seconds, %.2f MB/s\n",
+                stats.words, stats.bytes, seconds,
+                seconds > 0 ? (float)stats.bytes / seconds / 1e6f : 0.0f);
+        fprintf(stderr, "%ld misspelled, %ld different\n", stats.misses, stats.uniqueMisses);
+        printCacheStats(&dictionary, stderr);
+        dictionaryCleanUp(&dictionary);
+        return 0;
+    }
+
+    Suggestion* suggestions = malloc(sizeof(Suggestion) * numSuggestions);
     char inputBuffer[256];
     int quit = 0;
     while (!quit)
@@ -175,59 +997,15 @@ int main(int argc, const char** argv)
         if (!quit) {
             printf("Checking for a match...\n");
 
-            if (hashMapGet(map, word) == NULL) {
+            if (!dictionaryContains(&dictionary, word)) {
                 // The word wasn't found
                 printf("The inputted word \"%s\" is spelled incorrectly.\n", word);
-                // Create an array to hold the suggestions
-                struct HashLink** suggestions = malloc(NUM_SUGGESTIONS * sizeof(struct HashLink*));
-                for(int s = 0; s < NUM_SUGGESTIONS; s++) {
-                    suggestions[s] = NULL;
-                }
-                // Loop through the dictionary, calculating the Levenshtein distance for each entry
-                for (int i = 0; i < hashMapCapacity(map); i++) {
-                    struct HashLink *currentLink = map->table[i];
-                    if (currentLink != NULL) {
-                        // Loop through the links in the bucket
-                        while (currentLink != NULL) {
-                            // Calculate the distance for the current link
-                            int distance = computeLevenshtein(word, currentLink->key);
-                            // Update the link
-                            hashMapPut(map, currentLink->key, distance);
-                            // See if we should add it to the suggestions
-                            int smallestDistance = 100000;
-                            int smallestDistanceIndex = -1;
-                            for (int s = 0; s < NUM_SUGGESTIONS; s++) {
-                                // If any link is NULL add it and break out of the loop
-                                if (suggestions[s] == NULL) {
-                                    suggestions[s] = malloc(sizeof(struct Hashlink*));
-                                    suggestions[s]->key = currentLink->key;
-                                    suggestions[s]->value = currentLink->value;
-                                    suggestions[s]->next = NULL;
-                                    break;
-                                } else if (currentLink->value < suggestions[s]->value &&
-                                           suggestions[s]->value < smallestDistance) {
-                                    smallestDistance = suggestions[s]->value;
-                                    smallestDistanceIndex = s;
-                                }
-                            }
-                            // Add the item only if its distance is smaller than the smallest suggestion's distance
-                            if (smallestDistanceIndex > -1) {
-                                suggestions[smallestDistanceIndex]->key = currentLink->key;
-                                suggestions[smallestDistanceIndex]->value = currentLink->value;
-                            }
-                            // Move to the next link
-                            currentLink = currentLink->next;
-                        }
-                    }
-                }
-                // Print the list of suggestions
+                // Find the closest words
+                int numFound = dictionarySuggest(&dictionary, word, suggestions, numSuggestions);
                 printf("Did you mean...?\n");
-                for (int s = 0; s < NUM_SUGGESTIONS; s++) {
-                    //printf("%s (distance: %i)\n", suggestions[s]->key, suggestions[s]->value);
-                    printf("%s\n", suggestions[s]->key);
-                    free(suggestions[s]);
+                for (int s = 0; s < numFound; s++) {
+                    printf("%s\n", suggestions[s].word);
                 }
-                free(suggestions);
             } else {
                 // The word was found
                 printf("The inputted word \"%s\" is spelled correctly.\n", word);
@@ -248,6 +1026,8 @@ int main(int argc, const char** argv)
         free(word);
         // --- Spellchecker code ends here ---
     }
-    hashMapDelete(map);
+    free(suggestions);
+    printCacheStats(&dictionary, stdout);
+    dictionaryCleanUp(&dictionary);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "suggestion.h"
+#include "levenshtein.h"
+#include <string.h>
+#include <assert.h>
+
+/**
+ * Returns a positive number if the first suggestion ranks after the second,
+ * a negative one if it ranks before it and 0 if they are the same word.
+ * @param a
+ * @param b
+ * @return Comparison result.
+ */
+static int compareSuggestions(const Suggestion *a, const Suggestion *b) {
+    if (a->distance != b->distance) {
+        return a->distance < b->distance ? -1 : 1;
+    }
+    if (a->frequency != b->frequency) {
+        return a->frequency > b->frequency ? -1 : 1;
+    }
+    return strcmp(a->word, b->word);
+}
+
+/**
+ * Returns 1 if the suggestion is good enough for the search to stop on.
+ * @param topK
+ * @param suggestion
+ * @return 1 or 0.
+ */
+static int isGood(const TopK *topK, const Suggestion *suggestion) {
+    return suggestion->distance <= topK->stopDistance &&
+           suggestion->frequency >= topK->stopFrequency;
+}
+
+/**
+ * Moves the entry at the given index down the heap until both its children
+ * rank before it.
+ * @param heap
+ * @param count
+ * @param index
+ */
+static void siftDown(Suggestion *heap, int count, int index) {
+    Suggestion entry = heap[index];
+    while (2 * index + 1 < count) {
+        int child = 2 * index + 1;
+        if (child + 1 < count && compareSuggestions(&heap[child + 1], &heap[child]) > 0) {
+            child++;
+        }
+        if (compareSuggestions(&heap[child], &entry) <= 0) {
+            break;
+        }
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = entry;
+}
+
+/**
+ * Starts an empty selection that keeps up to capacity words in the given
+ * storage.
+ * @param topK
+ * @param storage Array of at least capacity suggestions.
+ * @param capacity Number of words to keep, k.
+ */
+void topKInit(TopK *topK, Suggestion *storage, int capacity) {
+    assert(capacity > 0);
+    topK->heap = storage;
+    topK->count = 0;
+    topK->capacity = capacity;
+    topK->stopDistance = -1;
+    topK->stopFrequency = 0;
+    topK->numGood = 0;
+}
+
+/**
+ * Lets the search stop once every kept word is within the given distance and
+ * has at least the given frequency. Must be called before any word is
+ * offered.
+ * @param topK
+ * @param stopDistance Largest distance of a good enough word, -1 to never
+ * stop early.
+ * @param stopFrequency Smallest frequency of a good enough word.
+ */
+void topKSetStop(TopK *topK, int stopDistance, int stopFrequency) {
+    assert(topK->count == 0);
+    topK->stopDistance = stopDistance;
+    topK->stopFrequency = stopFrequency;
+}
+
+/**
+ * Offers a word. Once k words are kept, it replaces the worst of them only
+ * if it ranks before it.
+ * @param topK
+ * @param word
+ * @param distance
+ * @param frequency
+ */
+void topKOffer(TopK *topK, const char *word, int distance, int frequency) {
+    Suggestion entry = { word, distance, frequency };
+    Suggestion *heap = topK->heap;
+    if (topK->count == topK->capacity) {
+        if (compareSuggestions(&entry, &heap[0]) >= 0) {
+            return;
+        }
+        topK->numGood += isGood(topK, &entry) - isGood(topK, &heap[0]);
+        heap[0] = entry;
+        siftDown(heap, topK->count, 0);
+        return;
+    }
+    topK->numGood += isGood(topK, &entry);
+    int i = topK->count++;
+    while (i > 0 && compareSuggestions(&heap[(i - 1) / 2], &entry) < 0) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = entry;
+}
+
+/**
+ * Returns the largest distance a word can have and still be kept. A word at
+ * exactly this distance may still lose on frequency or spelling.
+ * @param topK
+ * @return Distance bound, LEVENSHTEIN_UNBOUNDED while there is room.
+ */
+int topKBound(TopK *topK) {
+    return topK->count < topK->capacity ? LEVENSHTEIN_UNBOUNDED : topK->heap[0].distance;
+}
+
+/**
+ * Returns 1 once the search can stop early: all k words are kept and every
+ * one of them is good enough. Better words may remain unseen, so a search
+ * that stops early can differ from a full one.
+ * @param topK
+ * @return 1 to stop, 0 to keep searching.
+ */
+int topKDone(TopK *topK) {
+    return topK->numGood == topK->capacity;
+}
+
+/**
+ * Sorts the kept words best first, in place. The selection must not be
+ * offered more words afterwards.
+ * @param topK
+ * @return Number of words kept.
+ */
+int topKFinish(TopK *topK) {
+    for (int end = topK->count - 1; end > 0; end--) {
+        Suggestion worst = topK->heap[0];
+        topK->heap[0] = topK->heap[end];
+        topK->heap[end] = worst;
+        siftDown(topK->heap, end, 0);
+    }
+    return topK->count;
+}
@@ -0,0 +1,52 @@
+#ifndef SUGGESTION_H
+#define SUGGESTION_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+typedef struct Suggestion Suggestion;
+typedef struct TopK TopK;
+
+struct Suggestion
+{
+    const char* word;
+    int distance;
+    // How common the word is; higher ranks first among equal distances.
+    int frequency;
+};
+
+/*
+ * Keeps the best k of the words offered to it in a fixed array the caller
+ * provides, arranged as a max-heap with the worst kept word at the root.
+ * Words rank by distance, then by frequency (higher first), then by their
+ * characters, so the result never depends on the order the words were
+ * offered in. Offering a word never allocates and costs O(log k).
+ *
+ * A search may also be allowed to stop early: once all k kept words are
+ * close enough and common enough (see topKSetStop), topKDone tells the
+ * search to stop looking for better ones.
+ */
+struct TopK
+{
+    Suggestion* heap;
+    int count;
+    int capacity;
+    // Kept words count as good enough to stop on within stopDistance and at
+    // stopFrequency or above; stopDistance is -1 when searches never stop
+    // early.
+    int stopDistance;
+    int stopFrequency;
+    // Number of kept words that are good enough.
+    int numGood;
+};
+
+void topKInit(TopK* topK, Suggestion* storage, int capacity);
+void topKOffer(TopK* topK, const char* word, int distance, int frequency);
+void topKSetStop(TopK* topK, int stopDistance, int stopFrequency);
+int topKBound(TopK* topK);
+int topKDone(TopK* topK);
+int topKFinish(TopK* topK);
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "suggestionCache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+/**
+ * Copies the word into the buffer in lowercase.
+ * @param word
+ * @param key Buffer of at least strlen(word) + 1 characters.
+ */
+static void normalize(const char *word, char *key) {
+    int i = 0;
+    for (; word[i] != '\0'; i++) {
+        key[i] = (char) tolower((unsigned char) word[i]);
+    }
+    key[i] = '\0';
+}
+
+/**
+ * Creates the empty map of cached words. Its keys are borrowed from the
+ * entries, so it only allocates links.
+ * @param capacity Number of words the cache keeps.
+ * @return The map.
+ */
+static HashMap *newWordMap(int capacity) {
+    HashMap *map = hashMapNew(1);
+    hashMapUseArena(map);
+    hashMapReserve(map, capacity);
+    return map;
+}
+
+/**
+ * Takes the entry out of the recency list.
+ * @param cache
+ * @param index
+ */
+static void unlinkEntry(SuggestionCache *cache, int index) {
+    CacheEntry *entry = &cache->entries[index];
+    if (entry->newer >= 0) {
+        cache->entries[entry->newer].older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older >= 0) {
+        cache->entries[entry->older].newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+}
+
+/**
+ * Puts the entry at the most recently used end of the recency list.
+ * @param cache
+ * @param index
+ */
+static void linkNewest(SuggestionCache *cache, int index) {
+    CacheEntry *entry = &cache->entries[index];
+    entry->newer = -1;
+    entry->older = cache->newest;
+    if (cache->newest >= 0) {
+        cache->entries[cache->newest].newer = index;
+    } else {
+        cache->oldest = index;
+    }
+    cache->newest = index;
+}
+
+/**
+ * Creates an empty cache.
+ * @param capacity Number of words to keep.
+ * @param numSuggestions Number of suggestions kept for each word.
+ * @return The cache.
+ */
+SuggestionCache *suggestionCacheNew(int capacity, int numSuggestions) {
+    assert(capacity > 0);
+    assert(numSuggestions > 0);
+    SuggestionCache *cache = malloc(sizeof(SuggestionCache));
+    cache->map = newWordMap(capacity);
+    cache->entries = malloc(sizeof(CacheEntry) * capacity);
+    cache->suggestions = malloc(sizeof(Suggestion) * capacity * numSuggestions);
+    cache->capacity = capacity;
+    cache->size = 0;
+    cache->numSuggestions = numSuggestions;
+    cache->newest = -1;
+    cache->oldest = -1;
+    cache->hits = 0;
+    cache->misses = 0;
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
+
+/**
+ * Frees the cache and every word in it.
+ * @param cache
+ */
+void suggestionCacheDelete(SuggestionCache *cache) {
+    if (cache == NULL) {
+        return;
+    }
+    for (int i = 0; i < cache->size; i++) {
+        free(cache->entries[i].word);
+    }
+    hashMapDelete(cache->map);
+    free(cache->entries);
+    free(cache->suggestions);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+/**
+ * Copies out the suggestions cached for the word and marks it as the most
+ * recently used. Counts a hit or a miss.
+ * @param cache
+ * @param word
+ * @param suggestions Filled with the cached suggestions.
+ * @param numSuggestions Number of suggestions wanted, at most the number
+ * the cache keeps for each word.
+ * @return Number of suggestions copied, or -1 if the word is not cached.
+ */
+int suggestionCacheGet(SuggestionCache *cache, const char *word, Suggestion *suggestions,
+                       int numSuggestions) {
+    assert(cache != NULL);
+    assert(numSuggestions <= cache->numSuggestions);
+    char key[strlen(word) + 1];
+    normalize(word, key);
+
+    pthread_mutex_lock(&cache->lock);
+    int *value = hashMapGet(cache->map, key);
+    if (value == NULL) {
+        cache->misses++;
+        pthread_mutex_unlock(&cache->lock);
+        return -1;
+    }
+    int index = *value;
+    CacheEntry *entry = &cache->entries[index];
+    int count = entry->numFound < numSuggestions ? entry->numFound : numSuggestions;
+    memcpy(suggestions, &cache->suggestions[index * cache->numSuggestions],
+           sizeof(Suggestion) * count);
+    unlinkEntry(cache, index);
+    linkNewest(cache, index);
+    cache->hits++;
+    pthread_mutex_unlock(&cache->lock);
+    return count;
+}
+
+/**
+ * Caches the suggestions found for the word, replacing any it already had
+ * and making room by dropping the least recently used word if the cache is
+ * full.
+ * @param cache
+ * @param word
+ * @param suggestions
+ * @param numFound Number of suggestions; the extra ones beyond what the
+ * cache keeps for each word are dropped.
+ */
+void suggestionCachePut(SuggestionCache *cache, const char *word, const Suggestion *suggestions,
+                        int numFound) {
+    assert(cache != NULL);
+    char key[strlen(word) + 1];
+    normalize(word, key);
+    if (numFound > cache->numSuggestions) {
+        numFound = cache->numSuggestions;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    int index;
+    int *value = hashMapGet(cache->map, key);
+    if (value != NULL) {
+        index = *value;
+        unlinkEntry(cache, index);
+    } else {
+        if (cache->size < cache->capacity) {
+            index = cache->size++;
+        } else {
+            // Reuse the least recently used entry
+            index = cache->oldest;
+            unlinkEntry(cache, index);
+            hashMapRemove(cache->map, cache->entries[index].word);
+            free(cache->entries[index].word);
+        }
+        cache->entries[index].word = malloc(sizeof(char) * (strlen(key) + 1));
+        strcpy(cache->entries[index].word, key);
+        hashMapPutBorrowed(cache->map, cache->entries[index].word, index);
+    }
+    cache->entries[index].numFound = numFound;
+    memcpy(&cache->suggestions[index * cache->numSuggestions], suggestions,
+           sizeof(Suggestion) * numFound);
+    linkNewest(cache, index);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Drops every cached word, for when the dictionary the suggestions came from
+ * changes. The hit and miss counts are kept.
+ * @param cache
+ */
+void suggestionCacheClear(SuggestionCache *cache) {
+    assert(cache != NULL);
+    pthread_mutex_lock(&cache->lock);
+    for (int i = 0; i < cache->size; i++) {
+        free(cache->entries[i].word);
+    }
+    hashMapDelete(cache->map);
+    cache->map = newWordMap(cache->capacity);
+    cache->size = 0;
+    cache->newest = -1;
+    cache->oldest = -1;
+    pthread_mutex_unlock(&cache->lock);
+}
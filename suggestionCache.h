@@ -0,0 +1,62 @@
+#ifndef SUGGESTION_CACHE_H
+#define SUGGESTION_CACHE_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include <pthread.h>
+#include "hashMap.h"
+#include "suggestion.h"
+
+/*
+ * Bounded cache of the suggestions found for each misspelled word, so a word
+ * that keeps coming back costs one hash lookup instead of a search of the
+ * whole dictionary. Words are lowercased before they are used as keys. When
+ * the cache is full the least recently used word makes room. The suggested
+ * words point into the dictionary they came from, so the cache must be
+ * cleared whenever that dictionary changes. Every call locks the cache, so
+ * several threads can share one.
+ */
+
+typedef struct CacheEntry CacheEntry;
+typedef struct SuggestionCache SuggestionCache;
+
+struct CacheEntry
+{
+    // Lowercased word, owned by the entry; the map borrows it as its key.
+    char* word;
+    // Neighbours in the recency list, -1 at either end.
+    int newer;
+    int older;
+    int numFound;
+};
+
+struct SuggestionCache
+{
+    // Maps each cached word to the index of its entry.
+    HashMap* map;
+    CacheEntry* entries;
+    // numSuggestions suggestions for each entry.
+    Suggestion* suggestions;
+    int capacity;
+    int size;
+    int numSuggestions;
+    // Most and least recently used entries, -1 when the cache is empty.
+    int newest;
+    int oldest;
+    long hits;
+    long misses;
+    pthread_mutex_t lock;
+};
+
+SuggestionCache* suggestionCacheNew(int capacity, int numSuggestions);
+void suggestionCacheDelete(SuggestionCache* cache);
+int suggestionCacheGet(SuggestionCache* cache, const char* word, Suggestion* suggestions,
+                       int numSuggestions);
+void suggestionCachePut(SuggestionCache* cache, const char* word, const Suggestion* suggestions,
+                        int numFound);
+void suggestionCacheClear(SuggestionCache* cache);
+
+#endif
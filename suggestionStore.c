@@ -0,0 +1,339 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "suggestionStore.h"
+#include "dictSnapshot.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Bytes of payload before the per-suggestion fields: numFound and numWanted.
+#define PAYLOAD_COUNTS 8
+// Bytes of payload per suggestion: its distance and frequency.
+#define PAYLOAD_SUGGESTION 8
+
+/**
+ * Copies the word into the buffer in lowercase.
+ * @param word
+ * @param key Buffer of at least strlen(word) + 1 characters.
+ */
+static void normalize(const char *word, char *key) {
+    int i = 0;
+    for (; word[i] != '\0'; i++) {
+        key[i] = (char) tolower((unsigned char) word[i]);
+    }
+    key[i] = '\0';
+}
+
+/**
+ * Checks that a mapped store starts with a header for the fingerprint.
+ * @param file
+ * @param fingerprint
+ * @return 1 if the header matches, 0 otherwise.
+ */
+static int headerMatches(const MappedFile *file, uint64_t fingerprint) {
+    if (file->length < sizeof(StoreHeader)) {
+        return 0;
+    }
+    StoreHeader header;
+    memcpy(&header, file->data, sizeof(header));
+    return memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == STORE_VERSION && header.fingerprint == fingerprint;
+}
+
+/**
+ * Replaces the file with an empty store for the fingerprint. The header is
+ * written to a temporary file that is renamed over the old one, so another
+ * process never sees a half-written header.
+ * @param fileName
+ * @param fingerprint
+ * @return 1 on success, 0 if the file could not be written.
+ */
+static int writeEmptyStore(const char *fileName, uint64_t fingerprint) {
+    char tempName[strlen(fileName) + 8];
+    strcpy(tempName, fileName);
+    strcat(tempName, ".XXXXXX");
+    int descriptor = mkstemp(tempName);
+    if (descriptor < 0) {
+        return 0;
+    }
+    StoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.version = STORE_VERSION;
+    header.fingerprint = fingerprint;
+    int written = write(descriptor, &header, sizeof(header)) == (ssize_t) sizeof(header);
+    written = close(descriptor) == 0 && written;
+    if (!written || rename(tempName, fileName) != 0) {
+        unlink(tempName);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Checks a record's payload and finds the misspelled word in it.
+ * @param payload
+ * @param length Bytes of payload.
+ * @return The word, or NULL if the payload is malformed.
+ */
+static const char *recordWord(const char *payload, uint32_t length) {
+    if (length < PAYLOAD_COUNTS) {
+        return NULL;
+    }
+    uint32_t numFound;
+    uint32_t numWanted;
+    memcpy(&numFound, payload, 4);
+    memcpy(&numWanted, payload + 4, 4);
+    if (numFound > numWanted || numFound > (length - PAYLOAD_COUNTS) / PAYLOAD_SUGGESTION) {
+        return NULL;
+    }
+    // The word and each suggested word must be terminated inside the payload
+    const char *word = payload + PAYLOAD_COUNTS + numFound * PAYLOAD_SUGGESTION;
+    const char *text = word;
+    const char *end = payload + length;
+    for (uint32_t i = 0; i <= numFound; i++) {
+        const char *terminator = memchr(text, '\0', end - text);
+        if (terminator == NULL) {
+            return NULL;
+        }
+        text = terminator + 1;
+    }
+    return word;
+}
+
+/**
+ * Finds the next offset at which a record marker starts.
+ * @param data
+ * @param offset Offset to search from.
+ * @param length Bytes of data.
+ * @return The offset of the marker, or length if there is none.
+ */
+static size_t nextMarker(const char *data, size_t offset, size_t length) {
+    uint32_t marker = STORE_RECORD_MARKER;
+    char first;
+    memcpy(&first, &marker, 1);
+    while (offset + sizeof(marker) <= length) {
+        const char *found = memchr(data + offset, first, length - offset - (sizeof(marker) - 1));
+        if (found == NULL) {
+            break;
+        }
+        offset = (size_t) (found - data);
+        if (memcmp(found, &marker, sizeof(marker)) == 0) {
+            return offset;
+        }
+        offset++;
+    }
+    return length;
+}
+
+/**
+ * Indexes every intact record of the mapped store. A later record for a word
+ * replaces an earlier one. After a damaged record the walk skips ahead to
+ * the next record marker and checks the record there, so a damaged tail is
+ * only read through once.
+ * @param store
+ */
+static void indexRecords(SuggestionStore *store) {
+    const char *data = store->file->data;
+    size_t length = store->file->length;
+    size_t offset = sizeof(StoreHeader);
+    while (offset + sizeof(StoreRecord) <= length &&
+           offset + sizeof(StoreRecord) <= (size_t) INT_MAX) {
+        StoreRecord record;
+        memcpy(&record, data + offset, sizeof(record));
+        const char *payload = data + offset + sizeof(StoreRecord);
+        const char *word = NULL;
+        if (record.marker == STORE_RECORD_MARKER &&
+            record.length <= length - offset - sizeof(StoreRecord) &&
+            checksumUpdate(CHECKSUM_BASIS, payload, record.length) == record.checksum) {
+            word = recordWord(payload, record.length);
+        }
+        if (word == NULL) {
+            offset = nextMarker(data, offset + 1, length);
+            continue;
+        }
+        int payloadOffset = (int) (offset + sizeof(StoreRecord));
+        int *value = hashMapGet(store->index, word);
+        if (value != NULL) {
+            *value = payloadOffset;
+        } else {
+            hashMapPutBorrowed(store->index, word, payloadOffset);
+        }
+        store->loaded++;
+        offset += sizeof(StoreRecord) + record.length;
+    }
+}
+
+/**
+ * Maps the store for the given fingerprint. A missing store, or one written
+ * for a different fingerprint, is replaced by an empty one first. If the
+ * file can be read but not written, lookups still work and appends are
+ * dropped.
+ * @param fileName
+ * @param fingerprint Fingerprint of the dictionary the suggestions come from.
+ * @return The store, or NULL if no store could be opened or created.
+ */
+SuggestionStore *suggestionStoreOpen(const char *fileName, uint64_t fingerprint) {
+    assert(fileName != NULL);
+    MappedFile *file = NULL;
+    int descriptor = -1;
+    // A second try follows replacing the file. Another process may replace
+    // it again in between, in which case the store is not used
+    for (int attempt = 0; attempt < 2 && file == NULL; attempt++) {
+        int writable = 1;
+        descriptor = open(fileName, O_RDWR | O_APPEND);
+        if (descriptor < 0) {
+            writable = 0;
+            descriptor = open(fileName, O_RDONLY);
+        }
+        if (descriptor >= 0) {
+            // Mapping the descriptor that is appended to makes sure both are
+            // the same file even if it is being replaced
+            file = mappedFileMap(descriptor, 0);
+            if (file != NULL && !headerMatches(file, fingerprint)) {
+                mappedFileClose(file);
+                file = NULL;
+            }
+            if (file == NULL || !writable) {
+                close(descriptor);
+                descriptor = -1;
+            }
+        }
+        if (file == NULL && (attempt > 0 || !writeEmptyStore(fileName, fingerprint))) {
+            return NULL;
+        }
+    }
+
+    SuggestionStore *store = malloc(sizeof(SuggestionStore));
+    store->file = file;
+    store->index = hashMapNew(1);
+    hashMapUseArena(store->index);
+    store->descriptor = descriptor;
+    store->fingerprint = fingerprint;
+    store->loaded = 0;
+    store->hits = 0;
+    store->appended = 0;
+    indexRecords(store);
+    return store;
+}
+
+/**
+ * Unmaps the store, closes its file and frees it.
+ * @param store
+ */
+void suggestionStoreClose(SuggestionStore *store) {
+    if (store == NULL) {
+        return;
+    }
+    hashMapDelete(store->index);
+    mappedFileClose(store->file);
+    if (store->descriptor >= 0) {
+        close(store->descriptor);
+    }
+    free(store);
+}
+
+/**
+ * Reads the suggestions stored for the word. The suggested words point into
+ * the store's mapping and last until it is closed. Counts a hit.
+ * @param store
+ * @param word
+ * @param suggestions Filled with the stored suggestions.
+ * @param numSuggestions Number of suggestions wanted.
+ * @return Number of suggestions read, or -1 if the word is not stored or was
+ * stored with fewer suggestions asked for.
+ */
+int suggestionStoreGet(SuggestionStore *store, const char *word, Suggestion *suggestions,
+                       int numSuggestions) {
+    assert(store != NULL);
+    char key[strlen(word) + 1];
+    normalize(word, key);
+    int *value = hashMapGet(store->index, key);
+    if (value == NULL) {
+        return -1;
+    }
+    const char *payload = store->file->data + *value;
+    uint32_t numFound;
+    uint32_t numWanted;
+    memcpy(&numFound, payload, 4);
+    memcpy(&numWanted, payload + 4, 4);
+    if (numWanted < (uint32_t) numSuggestions) {
+        return -1;
+    }
+    int count = numFound < (uint32_t) numSuggestions ? (int) numFound : numSuggestions;
+    const char *fields = payload + PAYLOAD_COUNTS;
+    const char *text = fields + numFound * PAYLOAD_SUGGESTION;
+    // Skip the misspelled word
+    text += strlen(text) + 1;
+    for (int i = 0; i < count; i++) {
+        int32_t distance;
+        int32_t frequency;
+        memcpy(&distance, fields + i * PAYLOAD_SUGGESTION, 4);
+        memcpy(&frequency, fields + i * PAYLOAD_SUGGESTION + 4, 4);
+        suggestions[i].word = text;
+        suggestions[i].distance = distance;
+        suggestions[i].frequency = frequency;
+        text += strlen(text) + 1;
+    }
+    __atomic_fetch_add(&store->hits, 1, __ATOMIC_RELAXED);
+    return count;
+}
+
+/**
+ * Appends the suggestions found for the word to the store's file with a
+ * single write, so records from several threads or processes never
+ * interleave. Does nothing if the file could not be opened for writing.
+ * @param store
+ * @param word
+ * @param suggestions
+ * @param numFound Number of suggestions found.
+ * @param numSuggestions Number of suggestions that were asked for.
+ */
+void suggestionStoreAppend(SuggestionStore *store, const char *word,
+                           const Suggestion *suggestions, int numFound, int numSuggestions) {
+    assert(store != NULL);
+    assert(numFound <= numSuggestions);
+    if (store->descriptor < 0) {
+        return;
+    }
+    size_t length = PAYLOAD_COUNTS + (size_t) numFound * PAYLOAD_SUGGESTION + strlen(word) + 1;
+    for (int i = 0; i < numFound; i++) {
+        length += strlen(suggestions[i].word) + 1;
+    }
+    char *buffer = malloc(sizeof(StoreRecord) + length);
+    char *payload = buffer + sizeof(StoreRecord);
+
+    uint32_t counts[2] = { (uint32_t) numFound, (uint32_t) numSuggestions };
+    memcpy(payload, counts, PAYLOAD_COUNTS);
+    char *text = payload + PAYLOAD_COUNTS + numFound * PAYLOAD_SUGGESTION;
+    normalize(word, text);
+    text += strlen(text) + 1;
+    for (int i = 0; i < numFound; i++) {
+        int32_t fields[2] = { suggestions[i].distance, suggestions[i].frequency };
+        memcpy(payload + PAYLOAD_COUNTS + i * PAYLOAD_SUGGESTION, fields, PAYLOAD_SUGGESTION);
+        size_t wordLength = strlen(suggestions[i].word) + 1;
+        memcpy(text, suggestions[i].word, wordLength);
+        text += wordLength;
+    }
+
+    StoreRecord record;
+    record.marker = STORE_RECORD_MARKER;
+    record.length = (uint32_t) length;
+    record.checksum = checksumUpdate(CHECKSUM_BASIS, payload, length);
+    memcpy(buffer, &record, sizeof(record));
+    if (write(store->descriptor, buffer, sizeof(StoreRecord) + length) ==
+        (ssize_t) (sizeof(StoreRecord) + length)) {
+        __atomic_fetch_add(&store->appended, 1, __ATOMIC_RELAXED);
+    }
+    free(buffer);
+}
@@ -0,0 +1,87 @@
+#ifndef SUGGESTION_STORE_H
+#define SUGGESTION_STORE_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "hashMap.h"
+#include "mappedFile.h"
+#include "suggestion.h"
+#include <stdint.h>
+
+/*
+ * Suggestions saved in a file so they outlive the process. The file is a
+ * header holding the fingerprint of the dictionary the suggestions came
+ * from, followed by records appended one per misspelled word. Opening maps
+ * the file, indexes the records that are already there and answers lookups
+ * straight from the mapping; records added afterwards are appended with a
+ * single write each, so several processes can share one file. A file with
+ * a different fingerprint is replaced by an empty one, which throws out
+ * suggestions made for another dictionary.
+ *
+ * Records appended after opening are not read back; the suggestion cache in
+ * front of the store answers those words.
+ *
+ * Each record starts with a marker, its length and a checksum of its
+ * payload. A record cut short by a crash fails its checksum and is skipped
+ * by looking for the next marker. Integers are stored in the byte order of
+ * the machine that wrote the file, and are read with memcpy since records
+ * are not aligned.
+ */
+
+#define STORE_MAGIC "SUGSTORE"
+#define STORE_VERSION 1
+#define STORE_RECORD_MARKER 0x53554731u
+
+typedef struct StoreHeader StoreHeader;
+typedef struct StoreRecord StoreRecord;
+typedef struct SuggestionStore SuggestionStore;
+
+struct StoreHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fingerprint;
+};
+
+// Record header. The payload that follows is the number of suggestions
+// found and the number that was asked for, the distance and frequency of
+// each suggestion, then the misspelled word and the suggested words, all
+// null terminated.
+struct StoreRecord
+{
+    uint32_t marker;
+    // Bytes of payload.
+    uint32_t length;
+    uint64_t checksum;
+};
+
+struct SuggestionStore
+{
+    // Records present when the store was opened.
+    MappedFile* file;
+    // Maps each misspelled word in the mapping to the offset of its record's
+    // payload. Never changed after opening, so lookups need no lock.
+    HashMap* index;
+    // Descriptor new records are appended through, or -1 if the file could
+    // not be written.
+    int descriptor;
+    uint64_t fingerprint;
+    // Number of records indexed at open, lookups they answered and records
+    // appended since; updated atomically.
+    long loaded;
+    long hits;
+    long appended;
+};
+
+SuggestionStore* suggestionStoreOpen(const char* fileName, uint64_t fingerprint);
+void suggestionStoreClose(SuggestionStore* store);
+int suggestionStoreGet(SuggestionStore* store, const char* word, Suggestion* suggestions,
+                       int numSuggestions);
+void suggestionStoreAppend(SuggestionStore* store, const char* word,
+                           const Suggestion* suggestions, int numFound, int numSuggestions);
+
+#endif
@@ -5,6 +5,18 @@
 
 #include "CuTest.h"
 #include "hashMap.h"
+#include "dictSnapshot.h"
+#include "levenshtein.h"
+#include "bkTree.h"
+#include "wordTrie.h"
+#include "levenshteinBatch.h"
+#include "searchPool.h"
+#include "ringQueue.h"
+#include "concurrentHashMap.h"
+#include "suggestionCache.h"
+#include "suggestionStore.h"
+#include "wordCount.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
@@ -73,14 +85,13 @@ void histAdd(Histogram* hist, char* key)
 void histFromTable(Histogram* hist, HashMap* map)
 {
     histInit(hist);
-    for (int i = 0; i < map->capacity; i++)
+    HashMapIterator iterator;
+    hashMapIteratorInit(&iterator, map);
+    const char* key;
+    int* value;
+    while (hashMapIteratorNext(&iterator, &key, &value))
     {
-        HashLink* link = map->table[i];
-        while (link != NULL)
-        {
-            histAdd(hist, link->key);
-            link = link->next;
-        }
+        histAdd(hist, (char*) key);
     }
 }
 
@@ -145,7 +156,11 @@ void testCase(CuTest* test, HashLink* links, const char** notKeys, int numLinks,
     int sum = 0;
     for (int i = 0; i < map->capacity; i++)
     {
+#ifdef HASH_MAP_OPEN_ADDRESSING
+        if (map->hashes[i] == 0)
+#else
         if (map->table[i] == NULL)
+#endif
         {
             sum++;
         }
@@ -340,6 +355,1297 @@ void testValueUpdate(CuTest* test)
     hashMapDelete(map);
 }
 
+/**
+ * Tests counting with hashMapGetOrInsert and hashMapAddAll against counts
+ * kept with hashMapGet and hashMapPut, starting from a table small enough to
+ * resize many times.
+ * @param test
+ */
+void testGetOrInsert(CuTest* test)
+{
+    printf("\n--- Testing get-or-insert ---\n");
+    HashMap* map = hashMapNew(1);
+    int* value = hashMapGetOrInsert(map, "a", 7);
+    CuAssertIntEquals(test, 7, *value);
+    *value = 9;
+    CuAssertIntEquals(test, 9, *hashMapGetOrInsert(map, "a", 0));
+    CuAssertIntEquals(test, 1, hashMapSize(map));
+    hashMapDelete(map);
+
+    HashMap* counts = hashMapNew(1);
+    HashMap* expected = hashMapNew(1);
+    const char* keys[100];
+    char names[500][8];
+    srand(264);
+    for (int i = 0; i < 500; i++)
+    {
+        sprintf(names[i], "k%d", i);
+    }
+    for (int round = 0; round < 20; round++)
+    {
+        int numKeys = rand() % 100;
+        for (int i = 0; i < numKeys; i++)
+        {
+            keys[i] = names[rand() % 500];
+            int* count = hashMapGet(expected, keys[i]);
+            hashMapPut(expected, keys[i], count != NULL ? *count + 1 : 1);
+        }
+        if (round % 2 == 0)
+        {
+            hashMapAddAll(counts, keys, numKeys, 1);
+        }
+        else
+        {
+            for (int i = 0; i < numKeys; i++)
+            {
+                (*hashMapGetOrInsert(counts, keys[i], 0))++;
+            }
+        }
+    }
+    CuAssertIntEquals(test, hashMapSize(expected), hashMapSize(counts));
+    HashMapIterator iterator;
+    hashMapIteratorInit(&iterator, expected);
+    const char* key;
+    while (hashMapIteratorNext(&iterator, &key, &value))
+    {
+        int* count = hashMapGet(counts, key);
+        CuAssertPtrNotNull(test, count);
+        CuAssertIntEquals(test, *value, *count);
+    }
+    hashMapDelete(counts);
+    hashMapDelete(expected);
+}
+
+/**
+ * Checks that every key of an incrementally resized map has the expected
+ * value, -1 meaning absent, and that iteration visits each entry once.
+ */
+static void checkIncrementalMap(CuTest* test, HashMap* map, char names[][8], const int* expected,
+                                int numKeys)
+{
+    int size = 0;
+    for (int i = 0; i < numKeys; i++)
+    {
+        int* value = hashMapGet(map, names[i]);
+        if (expected[i] < 0)
+        {
+            CuAssertPtrEquals(test, NULL, value);
+        }
+        else
+        {
+            CuAssertPtrNotNull(test, value);
+            CuAssertIntEquals(test, expected[i], *value);
+            size++;
+        }
+    }
+    CuAssertIntEquals(test, size, hashMapSize(map));
+    int visited = 0;
+    HashMapIterator iterator;
+    hashMapIteratorInit(&iterator, map);
+    const char* key;
+    int* value;
+    while (hashMapIteratorNext(&iterator, &key, &value))
+    {
+        visited++;
+    }
+    CuAssertIntEquals(test, size, visited);
+}
+
+/**
+ * Tests that a map resizing a bucket at a time keeps every key reachable
+ * through random puts, increments and removes while both tables are live,
+ * that finishing the resize frees the old table, and that deleting a map in
+ * the middle of a resize frees both.
+ * @param test
+ */
+void testIncrementalResize(CuTest* test)
+{
+    printf("\n--- Testing incremental resize ---\n");
+    char names[3000][8];
+    int expected[3000];
+    for (int i = 0; i < 3000; i++)
+    {
+        sprintf(names[i], "w%d", i);
+        expected[i] = -1;
+    }
+    HashMap* map = hashMapNew(1);
+    hashMapSetIncrementalResize(map, 1);
+    int sawResize = 0;
+    srand(18);
+    for (int step = 0; step < 6000; step++)
+    {
+        int i = rand() % 3000;
+        switch (rand() % 4)
+        {
+        case 0:
+            hashMapRemove(map, names[i]);
+            expected[i] = -1;
+            break;
+        case 1:
+            (*hashMapGetOrInsert(map, names[i], 0))++;
+            expected[i] = expected[i] < 0 ? 1 : expected[i] + 1;
+            break;
+        default:
+            hashMapPut(map, names[i], step);
+            expected[i] = step;
+            break;
+        }
+#ifdef HASH_MAP_OPEN_ADDRESSING
+        sawResize |= map->oldHashes != NULL;
+#else
+        sawResize |= map->oldTable != NULL;
+#endif
+        if (step % 500 == 0)
+        {
+            checkIncrementalMap(test, map, names, expected, 3000);
+        }
+    }
+    CuAssertTrue(test, sawResize);
+    checkIncrementalMap(test, map, names, expected, 3000);
+    hashMapFinishResize(map);
+#ifdef HASH_MAP_OPEN_ADDRESSING
+    CuAssertPtrEquals(test, NULL, map->oldHashes);
+#else
+    CuAssertPtrEquals(test, NULL, map->oldTable);
+#endif
+    checkIncrementalMap(test, map, names, expected, 3000);
+    hashMapDelete(map);
+
+    // Maps deleted in the middle of a resize free both tables
+    map = hashMapNew(1);
+    hashMapSetIncrementalResize(map, 1);
+    hashMapUseArena(map);
+    for (int i = 0; i < 1000; i++)
+    {
+        hashMapPut(map, names[i], i);
+    }
+    hashMapDelete(map);
+}
+
+/**
+ * Tests that reserving room sizes the table to a power of two that holds the
+ * keys within the maximum load, so adding them never resizes it, and that
+ * reserving less than the map holds changes nothing.
+ * @param test
+ */
+void testReserve(CuTest* test)
+{
+    printf("\n--- Testing reserve ---\n");
+    HashMap* map = hashMapNew(10);
+    CuAssertIntEquals(test, 16, hashMapCapacity(map));
+    hashMapReserve(map, 5000);
+    int capacity = hashMapCapacity(map);
+    CuAssertIntEquals(test, 0, capacity & (capacity - 1));
+    CuAssertTrue(test, 5000.0f / capacity <= MAX_TABLE_LOAD);
+    char key[16];
+    for (int i = 0; i < 5000; i++)
+    {
+        sprintf(key, "r%d", i);
+        hashMapPut(map, key, i);
+    }
+    CuAssertIntEquals(test, capacity, hashMapCapacity(map));
+    CuAssertIntEquals(test, 5000, hashMapSize(map));
+    // Reserving less than the table holds leaves it alone
+    hashMapReserve(map, 10);
+    CuAssertIntEquals(test, capacity, hashMapCapacity(map));
+    for (int i = 0; i < 5000; i++)
+    {
+        sprintf(key, "r%d", i);
+        int* value = hashMapGet(map, key);
+        CuAssertPtrNotNull(test, value);
+        CuAssertIntEquals(test, i, *value);
+    }
+    hashMapDelete(map);
+}
+
+/**
+ * Tests the per-map load factors: the table stays under the map's maximum
+ * while growing, shrinks on remove to stay over its minimum until it drains
+ * to a single bucket, and with no minimum only hashMapCompact shrinks it,
+ * keeping the remaining keys.
+ * @param test
+ */
+void testLoadFactors(CuTest* test)
+{
+    printf("\n--- Testing load factors ---\n");
+    char key[16];
+    HashMap* map = hashMapNew(1);
+#ifdef HASH_MAP_OPEN_ADDRESSING
+    hashMapSetLoadFactors(map, 0.1f, 0.5f);
+#else
+    hashMapSetLoadFactors(map, 0.25f, 1.0f);
+#endif
+    for (int i = 0; i < 4000; i++)
+    {
+        sprintf(key, "f%d", i);
+        hashMapPut(map, key, i);
+        CuAssertTrue(test, hashMapTableLoad(map) <= map->maxLoad);
+    }
+    int fullCapacity = hashMapCapacity(map);
+
+    // Draining the map gives the table back a half at a time
+    for (int i = 0; i < 4000; i++)
+    {
+        sprintf(key, "f%d", i);
+        hashMapRemove(map, key);
+        CuAssertTrue(test, hashMapSize(map) == 0 || hashMapTableLoad(map) >= map->minLoad);
+        if (i % 7 == 0 && i + 1 < 4000)
+        {
+            sprintf(key, "f%d", i + 1);
+            CuAssertPtrNotNull(test, hashMapGet(map, key));
+        }
+    }
+    CuAssertIntEquals(test, 0, hashMapSize(map));
+    CuAssertIntEquals(test, 1, hashMapCapacity(map));
+    hashMapDelete(map);
+
+    // Without a minimum only compacting shrinks the table
+    map = hashMapNew(1);
+    hashMapSetIncrementalResize(map, 1);
+    hashMapSetLoadFactors(map, 0, MAX_TABLE_LOAD);
+    for (int i = 0; i < 4000; i++)
+    {
+        sprintf(key, "f%d", i);
+        hashMapPut(map, key, i);
+    }
+    for (int i = 0; i < 3990; i++)
+    {
+        sprintf(key, "f%d", i);
+        hashMapRemove(map, key);
+    }
+    CuAssertTrue(test, hashMapCapacity(map) >= fullCapacity / 4);
+    hashMapCompact(map);
+    CuAssertTrue(test, hashMapCapacity(map) <= 16);
+    CuAssertTrue(test, hashMapTableLoad(map) <= MAX_TABLE_LOAD);
+    for (int i = 3990; i < 4000; i++)
+    {
+        sprintf(key, "f%d", i);
+        int* value = hashMapGet(map, key);
+        CuAssertPtrNotNull(test, value);
+        CuAssertIntEquals(test, i, *value);
+    }
+    hashMapDelete(map);
+}
+
+/**
+ * Tests that every hash function can be selected on an empty table and finds
+ * all of its keys, and that the chain histogram accounts for the whole table.
+ * @param test
+ */
+void testHashFunctions(CuTest* test)
+{
+    printf("\n--- Testing hash functions ---\n");
+    const char* names[] = { "sum", "weighted", "fnv1a", "mix64" };
+    const char* keys[] = { "ab", "ba", "listen", "silent", "enlist", "a", "" };
+    int numKeys = 7;
+    CuAssertPtrEquals(test, NULL, hashFunctionByName("unknown"));
+    for (int i = 0; i < 4; i++)
+    {
+        HashFunction function = hashFunctionByName(names[i]);
+        CuAssertPtrNotNull(test, function);
+        HashMap* map = hashMapNew(3);
+        hashMapSetHashFunction(map, function, 12345);
+        for (int k = 0; k < numKeys; k++)
+        {
+            hashMapPut(map, keys[k], k);
+        }
+        CuAssertIntEquals(test, numKeys, hashMapSize(map));
+        for (int k = 0; k < numKeys; k++)
+        {
+            int* value = hashMapGet(map, keys[k]);
+            CuAssertPtrNotNull(test, value);
+            CuAssertIntEquals(test, k, *value);
+        }
+
+        int histogram[4];
+        hashMapChainHistogram(map, histogram, 4);
+        int buckets = 0;
+        int links = 0;
+        for (int n = 0; n < 4; n++)
+        {
+            buckets += histogram[n];
+            links += n * histogram[n];
+        }
+#ifdef HASH_MAP_OPEN_ADDRESSING
+        CuAssertIntEquals(test, numKeys, buckets);
+#else
+        CuAssertIntEquals(test, hashMapCapacity(map), buckets);
+        CuAssertIntEquals(test, hashMapEmptyBuckets(map), histogram[0]);
+        CuAssertTrue(test, links <= numKeys);
+#endif
+        hashMapDelete(map);
+    }
+
+    // Seeded functions depend on the seed, the simple sums do not
+    CuAssertTrue(test, hashFunctionMix64("seed", 1) != hashFunctionMix64("seed", 2));
+    CuAssertTrue(test, hashFunctionFnv1a("seed", 1) != hashFunctionFnv1a("seed", 2));
+    CuAssertIntEquals(test, hashFunction1("seed", 1), hashFunction1("seed", 2));
+}
+
+/**
+ * Tests an arena-backed table through inserts, removals that recycle links and
+ * re-inserts, across several resizes.
+ * @param test
+ */
+void testArena(CuTest* test)
+{
+    printf("\n--- Testing arena-backed table ---\n");
+    HashMap* map = hashMapNew(1);
+    hashMapUseArena(map);
+    char key[16];
+    for (int i = 0; i < 1000; i++)
+    {
+        sprintf(key, "key%d", i);
+        hashMapPut(map, key, i);
+    }
+    for (int i = 0; i < 1000; i += 2)
+    {
+        sprintf(key, "key%d", i);
+        hashMapRemove(map, key);
+    }
+    CuAssertIntEquals(test, 500, hashMapSize(map));
+    for (int i = 0; i < 1000; i += 4)
+    {
+        sprintf(key, "again%d", i);
+        hashMapPut(map, key, -i);
+    }
+    CuAssertIntEquals(test, 750, hashMapSize(map));
+    for (int i = 0; i < 1000; i++)
+    {
+        sprintf(key, "key%d", i);
+        int* value = hashMapGet(map, key);
+        if (i % 2 == 0)
+        {
+            CuAssertPtrEquals(test, NULL, value);
+        }
+        else
+        {
+            CuAssertPtrNotNull(test, value);
+            CuAssertIntEquals(test, i, *value);
+        }
+        if (i % 4 == 0)
+        {
+            sprintf(key, "again%d", i);
+            value = hashMapGet(map, key);
+            CuAssertPtrNotNull(test, value);
+            CuAssertIntEquals(test, -i, *value);
+        }
+    }
+    hashMapDelete(map);
+}
+
+/**
+ * Tests that a snapshot saved from a table finds the same keys and values,
+ * and that a corrupted snapshot is rejected, as is one whose checksum holds
+ * but whose slots point outside the keys or leave no slot empty.
+ * @param test
+ */
+void testSnapshot(CuTest* test)
+{
+    printf("\n--- Testing dictionary snapshots ---\n");
+    const char* fileName = "tests.snap";
+    const char* keys[] = { "ab", "ba", "listen", "silent", "c" };
+    HashMap* map = hashMapNew(1);
+    for (int i = 0; i < 5; i++)
+    {
+        hashMapPut(map, keys[i], i * 10);
+    }
+    CuAssertIntEquals(test, 1, dictSnapshotWrite(map, fileName));
+    hashMapDelete(map);
+
+    DictSnapshot* snapshot = dictSnapshotOpen(fileName);
+    CuAssertPtrNotNull(test, snapshot);
+    CuAssertIntEquals(test, 5, dictSnapshotSize(snapshot));
+    for (int i = 0; i < 5; i++)
+    {
+        const int32_t* value = dictSnapshotGet(snapshot, keys[i]);
+        CuAssertPtrNotNull(test, (void*) value);
+        CuAssertIntEquals(test, i * 10, *value);
+    }
+    CuAssertPtrEquals(test, NULL, (void*) dictSnapshotGet(snapshot, "b"));
+    int numKeys = 0;
+    for (const char* key = dictSnapshotNextKey(snapshot, NULL); key != NULL;
+         key = dictSnapshotNextKey(snapshot, key))
+    {
+        numKeys++;
+    }
+    CuAssertIntEquals(test, 5, numKeys);
+    dictSnapshotClose(snapshot);
+
+    // Point an occupied slot past the keys and fix up the checksum, as a
+    // writer bug would
+    FILE* file = fopen(fileName, "r+b");
+    SnapshotHeader header;
+    CuAssertIntEquals(test, 1, (int) fread(&header, sizeof(header), 1, file));
+    SnapshotSlot* slots = malloc(sizeof(SnapshotSlot) * header.numSlots);
+    char* packed = malloc(header.keysLength);
+    CuAssertIntEquals(test, (int) header.numSlots,
+                      (int) fread(slots, sizeof(SnapshotSlot), header.numSlots, file));
+    CuAssertIntEquals(test, 1, (int) fread(packed, header.keysLength, 1, file));
+    int occupied = 0;
+    while (slots[occupied].hash == 0)
+    {
+        occupied++;
+    }
+    uint32_t keyOffset = slots[occupied].keyOffset;
+    slots[occupied].keyOffset = (uint32_t) header.keysLength + 1000;
+    SnapshotHeader bad = header;
+    bad.checksum = checksumUpdate(CHECKSUM_BASIS, slots, sizeof(SnapshotSlot) * header.numSlots);
+    bad.checksum = checksumUpdate(bad.checksum, packed, header.keysLength);
+    rewind(file);
+    fwrite(&bad, sizeof(bad), 1, file);
+    fwrite(slots, sizeof(SnapshotSlot), header.numSlots, file);
+    fflush(file);
+    CuAssertPtrEquals(test, NULL, dictSnapshotOpen(fileName));
+
+    // Claim every slot is taken, so probes for missing keys would never end
+    slots[occupied].keyOffset = keyOffset;
+    bad = header;
+    bad.numEntries = header.numSlots;
+    rewind(file);
+    fwrite(&bad, sizeof(bad), 1, file);
+    fwrite(slots, sizeof(SnapshotSlot), header.numSlots, file);
+    fflush(file);
+    CuAssertPtrEquals(test, NULL, dictSnapshotOpen(fileName));
+
+    // Restoring the header makes the file valid again
+    rewind(file);
+    fwrite(&header, sizeof(header), 1, file);
+    fflush(file);
+    snapshot = dictSnapshotOpen(fileName);
+    CuAssertPtrNotNull(test, snapshot);
+    dictSnapshotClose(snapshot);
+
+    // Flip the last byte of the packed keys
+    fseek(file, -1, SEEK_END);
+    fputc('x', file);
+    fclose(file);
+    CuAssertPtrEquals(test, NULL, dictSnapshotOpen(fileName));
+    free(slots);
+    free(packed);
+    remove(fileName);
+}
+
+/**
+ * Tests that the sorted listing ranks words by count and then alphabetically,
+ * the same whatever order the map was filled in, and that the top-N listing
+ * is its first N entries.
+ * @param test
+ */
+void testWordCountRanking(CuTest* test)
+{
+    printf("\n--- Testing word count ranking ---\n");
+    int numWords = 2000;
+    char names[2000][8];
+    int order[2000];
+    for (int i = 0; i < numWords; i++)
+    {
+        sprintf(names[i], "w%d", i);
+        order[i] = i;
+    }
+    srand(17);
+    WordCount* sorted[2];
+    HashMap* maps[2];
+    for (int m = 0; m < 2; m++)
+    {
+        // Fill the maps in different orders, with plenty of tied counts
+        for (int i = numWords - 1; i > 0; i--)
+        {
+            int j = rand() % (i + 1);
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        maps[m] = hashMapNew(m == 0 ? 1 : 4096);
+        for (int i = 0; i < numWords; i++)
+        {
+            hashMapPut(maps[m], names[order[i]], 1 + order[i] % 7 + (order[i] % 100 == 0 ? 300 : 0));
+        }
+        sorted[m] = extractCounts(maps[m]);
+        radixSortCounts(sorted[m], numWords);
+    }
+    for (int i = 0; i < numWords; i++)
+    {
+        CuAssertStrEquals(test, sorted[0][i].word, sorted[1][i].word);
+        CuAssertIntEquals(test, sorted[0][i].count, sorted[1][i].count);
+        if (i > 0)
+        {
+            CuAssertTrue(test, sorted[0][i - 1].count > sorted[0][i].count ||
+                               (sorted[0][i - 1].count == sorted[0][i].count &&
+                                strcmp(sorted[0][i - 1].word, sorted[0][i].word) < 0));
+        }
+    }
+    int tops[] = { 1, 5, 20, 300, 2000, 3000 };
+    for (int t = 0; t < 6; t++)
+    {
+        WordCount* entries = extractCounts(maps[1]);
+        int n = selectTopCounts(entries, numWords, tops[t]);
+        CuAssertIntEquals(test, tops[t] < numWords ? tops[t] : numWords, n);
+        for (int i = 0; i < n; i++)
+        {
+            CuAssertStrEquals(test, sorted[0][i].word, entries[i].word);
+        }
+        free(entries);
+    }
+    for (int m = 0; m < 2; m++)
+    {
+        free(sorted[m]);
+        hashMapDelete(maps[m]);
+    }
+}
+
+// --- Edit distance tests ---
+
+/**
+ * Fills the buffer with a random word over a small alphabet, so that pairs
+ * of words share plenty of characters.
+ * @param word Buffer of at least length + 1 characters.
+ * @param length
+ */
+void randomWord(char* word, int length)
+{
+    for (int i = 0; i < length; i++)
+    {
+        word[i] = "abcde"[rand() % 5];
+    }
+    word[length] = '\0';
+}
+
+/**
+ * Tests the bounded distance against the full DP on fixed and random pairs,
+ * including words longer than 64 characters, for a range of bounds.
+ * @param test
+ */
+void testLevenshteinBounded(CuTest* test)
+{
+    printf("\n--- Testing bounded edit distance ---\n");
+    CuAssertIntEquals(test, 3, levenshteinBounded("kitten", "sitting", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 3, levenshteinBounded("kitten", "sitting", 3));
+    CuAssertIntEquals(test, 3, levenshteinBounded("kitten", "sitting", 2));
+    CuAssertIntEquals(test, 5, levenshteinBounded("", "abcde", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 2, levenshteinBounded("abcde", "a", 1));
+    CuAssertIntEquals(test, 0, levenshteinBounded("same", "same", 0));
+
+    char s1[101];
+    char s2[101];
+    srand(261);
+    for (int i = 0; i < 2000; i++)
+    {
+        randomWord(s1, rand() % 100);
+        randomWord(s2, rand() % 100);
+        int expected = computeLevenshtein(s1, s2);
+        CuAssertIntEquals(test, expected, levenshteinBounded(s1, s2, LEVENSHTEIN_UNBOUNDED));
+        int bound = rand() % 20;
+        int bounded = levenshteinBounded(s1, s2, bound);
+        CuAssertIntEquals(test, expected <= bound ? expected : bound + 1, bounded);
+    }
+}
+
+/**
+ * Optimal string alignment distance by the full DP, with unit costs.
+ * @param s1
+ * @param s2
+ * @return The distance.
+ */
+int referenceDamerau(const char* s1, const char* s2)
+{
+    int len1 = (int) strlen(s1);
+    int len2 = (int) strlen(s2);
+    int* d = malloc(sizeof(int) * (len1 + 1) * (len2 + 1));
+    for (int i = 0; i <= len1; i++)
+    {
+        for (int j = 0; j <= len2; j++)
+        {
+            int value;
+            if (i > 0 && j > 0)
+            {
+                value = d[(i - 1) * (len2 + 1) + j - 1] + (s1[i - 1] != s2[j - 1]);
+                if (d[(i - 1) * (len2 + 1) + j] + 1 < value)
+                {
+                    value = d[(i - 1) * (len2 + 1) + j] + 1;
+                }
+                if (d[i * (len2 + 1) + j - 1] + 1 < value)
+                {
+                    value = d[i * (len2 + 1) + j - 1] + 1;
+                }
+                if (i > 1 && j > 1 && s1[i - 1] == s2[j - 2] && s1[i - 2] == s2[j - 1] &&
+                    d[(i - 2) * (len2 + 1) + j - 2] + 1 < value)
+                {
+                    value = d[(i - 2) * (len2 + 1) + j - 2] + 1;
+                }
+            }
+            else
+            {
+                value = i + j;
+            }
+            d[i * (len2 + 1) + j] = value;
+        }
+    }
+    int distance = d[len1 * (len2 + 1) + len2];
+    free(d);
+    return distance;
+}
+
+/**
+ * Tests the Damerau distance against the full DP, the keyboard distance on
+ * known typos, and that the bounded versions of both agree with the
+ * unbounded ones. Then checks that the index and the batch find the same
+ * distances as measuring every word.
+ * @param test
+ */
+void testEditMetrics(CuTest* test)
+{
+    printf("\n--- Testing Damerau and keyboard distances ---\n");
+    CuAssertIntEquals(test, 1, damerauBounded("teh", "the", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 2, levenshteinBounded("teh", "the", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 3, damerauBounded("ca", "abc", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 2, keyboardDistanceBounded("teh", "the", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 1, keyboardDistanceBounded("thw", "the", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 1, keyboardDistanceBounded("cst", "cat", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 1, keyboardDistanceBounded("xat", "cat", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 2, keyboardDistanceBounded("cut", "cat", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 2, keyboardDistanceBounded("at", "cat", LEVENSHTEIN_UNBOUNDED));
+    CuAssertIntEquals(test, 2, keyboardDistanceBounded("at", "cat", 1));
+    CuAssertIntEquals(test, 0, keyboardDistanceBounded("", "", 0));
+    CuAssertIntEquals(test, METRIC_KEYBOARD, editMetricByName("keyboard"));
+    CuAssertIntEquals(test, -1, editMetricByName("hamming"));
+
+    srand(264);
+    char s1[101];
+    char s2[101];
+    for (int round = 0; round < 2000; round++)
+    {
+        // Mostly short pairs over a small alphabet, some past 64 characters
+        int maxLength = round % 10 == 0 ? 100 : 12;
+        randomWord(s1, rand() % (maxLength + 1));
+        randomWord(s2, rand() % (maxLength + 1));
+        int expected = referenceDamerau(s1, s2);
+        CuAssertIntEquals(test, expected, damerauBounded(s1, s2, LEVENSHTEIN_UNBOUNDED));
+        int keyboard = keyboardDistanceBounded(s1, s2, LEVENSHTEIN_UNBOUNDED);
+        CuAssertIntEquals(test, keyboard, keyboardDistanceBounded(s2, s1, LEVENSHTEIN_UNBOUNDED));
+        CuAssertTrue(test, keyboard >= levenshteinBounded(s1, s2, LEVENSHTEIN_UNBOUNDED));
+        for (int bound = 0; bound <= 8; bound++)
+        {
+            int damerau = damerauBounded(s1, s2, bound);
+            CuAssertIntEquals(test, expected <= bound ? expected : bound + 1, damerau);
+            CuAssertIntEquals(test, keyboard <= bound ? keyboard : bound + 1,
+                              keyboardDistanceBounded(s1, s2, bound));
+        }
+    }
+
+    int numWords = 300;
+    char* words[300];
+    BkTree* tree = bkTreeNew();
+    for (int i = 0; i < numWords; i++)
+    {
+        // The tree keeps one copy of each word, so the words must differ
+        words[i] = malloc(9);
+        int unique = 0;
+        while (!unique)
+        {
+            randomWord(words[i], 1 + rand() % 8);
+            unique = 1;
+            for (int j = 0; j < i; j++)
+            {
+                unique = unique && strcmp(words[i], words[j]) != 0;
+            }
+        }
+        bkTreeAdd(tree, words[i], 0);
+    }
+    WordBatch* batch = wordBatchNew((const char**) words, NULL, numWords);
+    char query[9];
+    for (int metric = METRIC_DAMERAU; metric <= METRIC_KEYBOARD; metric++)
+    {
+        for (int q = 0; q < 30; q++)
+        {
+            randomWord(query, 1 + rand() % 8);
+            // The k-th smallest distance over every word
+            Suggestion storage[5];
+            TopK topK;
+            topKInit(&topK, storage, 5);
+            for (int i = 0; i < numWords; i++)
+            {
+                topKOffer(&topK, words[i],
+                          editDistanceBounded(metric, query, words[i], LEVENSHTEIN_UNBOUNDED), 0);
+            }
+            topKFinish(&topK);
+            Suggestion fromTree[5];
+            Suggestion fromBatch[5];
+            bkTreeSearch(tree, query, fromTree, 5, metric);
+            wordBatchSearch(batch, query, fromBatch, 5, metric);
+            for (int s = 0; s < 5; s++)
+            {
+                CuAssertIntEquals(test, storage[s].distance, fromTree[s].distance);
+                CuAssertIntEquals(test, storage[s].distance, fromBatch[s].distance);
+            }
+        }
+    }
+    bkTreeDelete(tree);
+    wordBatchDelete(batch);
+    for (int i = 0; i < numWords; i++)
+    {
+        free(words[i]);
+    }
+}
+
+/**
+ * Tests trie membership, including prefixes that are not words themselves,
+ * and that trie searches rank the same words as measuring every word, for
+ * every metric.
+ * @param test
+ */
+void testWordTrie(CuTest* test)
+{
+    printf("\n--- Testing the word trie ---\n");
+    const char* small[] = { "car", "cart", "care", "cat", "a", "car", "dog" };
+    WordTrie* trie = wordTrieNew(small, NULL, 7);
+    CuAssertIntEquals(test, 6, trie->numWords);
+    CuAssertIntEquals(test, 4, trie->maxLength);
+    CuAssertIntEquals(test, 1, wordTrieContains(trie, "car"));
+    CuAssertIntEquals(test, 1, wordTrieContains(trie, "cart"));
+    CuAssertIntEquals(test, 1, wordTrieContains(trie, "a"));
+    CuAssertIntEquals(test, 1, wordTrieContains(trie, "dog"));
+    CuAssertIntEquals(test, 0, wordTrieContains(trie, "ca"));
+    CuAssertIntEquals(test, 0, wordTrieContains(trie, "carts"));
+    CuAssertIntEquals(test, 0, wordTrieContains(trie, "cab"));
+    CuAssertIntEquals(test, 0, wordTrieContains(trie, "b"));
+    CuAssertIntEquals(test, 0, wordTrieContains(trie, ""));
+    wordTrieDelete(trie);
+
+    srand(265);
+    int numWords = 400;
+    char* words[400];
+    int frequencies[400];
+    for (int i = 0; i < numWords; i++)
+    {
+        // The trie keeps one copy of each word, so the words must differ
+        words[i] = malloc(11);
+        int unique = 0;
+        while (!unique)
+        {
+            randomWord(words[i], 1 + rand() % 10);
+            unique = 1;
+            for (int j = 0; j < i; j++)
+            {
+                unique = unique && strcmp(words[i], words[j]) != 0;
+            }
+        }
+        frequencies[i] = rand() % 3;
+    }
+    trie = wordTrieNew((const char**) words, frequencies, numWords);
+    for (int i = 0; i < numWords; i++)
+    {
+        CuAssertIntEquals(test, 1, wordTrieContains(trie, words[i]));
+    }
+    char query[12];
+    for (int metric = METRIC_LEVENSHTEIN; metric <= METRIC_KEYBOARD; metric++)
+    {
+        for (int q = 0; q < 40; q++)
+        {
+            randomWord(query, rand() % 12);
+            Suggestion storage[5];
+            TopK topK;
+            topKInit(&topK, storage, 5);
+            for (int i = 0; i < numWords; i++)
+            {
+                topKOffer(&topK, words[i],
+                          editDistanceBounded(metric, query, words[i], LEVENSHTEIN_UNBOUNDED),
+                          frequencies[i]);
+            }
+            topKFinish(&topK);
+            Suggestion fromTrie[5];
+            CuAssertIntEquals(test, 5, wordTrieSearch(trie, query, fromTrie, 5, metric));
+            for (int s = 0; s < 5; s++)
+            {
+                CuAssertStrEquals(test, storage[s].word, fromTrie[s].word);
+                CuAssertIntEquals(test, storage[s].distance, fromTrie[s].distance);
+            }
+        }
+    }
+    wordTrieDelete(trie);
+    for (int i = 0; i < numWords; i++)
+    {
+        free(words[i]);
+    }
+}
+
+/**
+ * Tests that the top-k selection keeps the best words ranked by distance,
+ * frequency and spelling, whatever order they are offered in.
+ * @param test
+ */
+void testTopK(CuTest* test)
+{
+    printf("\n--- Testing top-k selection ---\n");
+    const char* words[] = { "delta", "alpha", "echo", "bravo", "golf", "charlie", "foxtrot" };
+    int distances[] = { 1, 1, 2, 1, 3, 0, 2 };
+    int frequencies[] = { 0, 0, 0, 5, 0, 0, 1 };
+    const char* expected[] = { "charlie", "bravo", "alpha", "delta", "foxtrot" };
+    int numWords = 7;
+
+    srand(263);
+    for (int round = 0; round < 50; round++)
+    {
+        int order[7];
+        for (int i = 0; i < numWords; i++)
+        {
+            order[i] = i;
+        }
+        for (int i = numWords - 1; i > 0; i--)
+        {
+            int j = rand() % (i + 1);
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        Suggestion storage[5];
+        TopK topK;
+        topKInit(&topK, storage, 5);
+        for (int i = 0; i < numWords; i++)
+        {
+            topKOffer(&topK, words[order[i]], distances[order[i]], frequencies[order[i]]);
+        }
+        CuAssertIntEquals(test, 2, topKBound(&topK));
+        CuAssertIntEquals(test, 5, topKFinish(&topK));
+        for (int s = 0; s < 5; s++)
+        {
+            CuAssertStrEquals(test, expected[s], storage[s].word);
+        }
+    }
+
+    Suggestion one[1];
+    TopK topK;
+    topKInit(&topK, one, 1);
+    CuAssertIntEquals(test, LEVENSHTEIN_UNBOUNDED, topKBound(&topK));
+    CuAssertIntEquals(test, 0, topKFinish(&topK));
+}
+
+/**
+ * Tests that the index and the batch rank words at equal distance by
+ * frequency, and that both stop early once the suggestions are good enough.
+ * @param test
+ */
+void testFrequencyRanking(CuTest* test)
+{
+    printf("\n--- Testing frequency ranking ---\n");
+    const char* words[] = { "cat", "cut", "cot", "coat", "cart", "dog", "cast", "at" };
+    int frequencies[] = { 50, 3, 9, 20, 0, 70, 40, 60 };
+    const char* expected[] = { "cat", "cot", "cut", "at", "cast" };
+    int numWords = 8;
+    BkTree* tree = bkTreeNew();
+    for (int i = 0; i < numWords; i++)
+    {
+        bkTreeAdd(tree, words[i], frequencies[i]);
+    }
+    WordBatch* batch = wordBatchNew(words, frequencies, numWords);
+    Suggestion fromTree[5];
+    Suggestion fromBatch[5];
+    CuAssertIntEquals(test, 5, bkTreeSearch(tree, "cht", fromTree, 5, METRIC_LEVENSHTEIN));
+    CuAssertIntEquals(test, 5, wordBatchSearch(batch, "cht", fromBatch, 5, METRIC_LEVENSHTEIN));
+    for (int s = 0; s < 5; s++)
+    {
+        CuAssertStrEquals(test, expected[s], fromTree[s].word);
+        CuAssertStrEquals(test, expected[s], fromBatch[s].word);
+    }
+    CuAssertIntEquals(test, 9, fromTree[1].frequency);
+
+    bkTreeDelete(tree);
+    wordBatchDelete(batch);
+
+    // "at" is seen first by both: it is the tree's root, and its length is
+    // scanned before that of the closer "chat"
+    const char* stopWords[] = { "at", "chat", "cast" };
+    int stopFrequencies[] = { 60, 0, 40 };
+    tree = bkTreeNew();
+    for (int i = 0; i < 3; i++)
+    {
+        bkTreeAdd(tree, stopWords[i], stopFrequencies[i]);
+    }
+    batch = wordBatchNew(stopWords, stopFrequencies, 3);
+    CuAssertIntEquals(test, 1, bkTreeSearch(tree, "cht", fromTree, 1, METRIC_LEVENSHTEIN));
+    CuAssertIntEquals(test, 1, wordBatchSearch(batch, "cht", fromBatch, 1, METRIC_LEVENSHTEIN));
+    CuAssertStrEquals(test, "chat", fromTree[0].word);
+    CuAssertStrEquals(test, "chat", fromBatch[0].word);
+    // A common word within distance 2 is good enough to stop on
+    bkTreeSetEarlyStop(tree, 2, 40);
+    wordBatchSetEarlyStop(batch, 2, 40);
+    CuAssertIntEquals(test, 1, bkTreeSearch(tree, "cht", fromTree, 1, METRIC_LEVENSHTEIN));
+    CuAssertIntEquals(test, 1, wordBatchSearch(batch, "cht", fromBatch, 1, METRIC_LEVENSHTEIN));
+    CuAssertStrEquals(test, "at", fromTree[0].word);
+    CuAssertStrEquals(test, "at", fromBatch[0].word);
+    bkTreeDelete(tree);
+    wordBatchDelete(batch);
+
+    TopK topK;
+    topKInit(&topK, fromTree, 2);
+    topKSetStop(&topK, 1, 10);
+    topKOffer(&topK, "cot", 1, 9);
+    topKOffer(&topK, "cat", 1, 50);
+    CuAssertIntEquals(test, 0, topKDone(&topK));
+    topKOffer(&topK, "cut", 1, 30);
+    CuAssertIntEquals(test, 1, topKDone(&topK));
+}
+
+/**
+ * Tests every batch kernel the CPU supports, not just the one the batch
+ * picks, against the full DP on blocks of random words, including words up
+ * to BATCH_MAX_LENGTH long.
+ * @param test
+ */
+void testBatchKernels(CuTest* test)
+{
+    printf("\n--- Testing batch kernels ---\n");
+    static char words[BATCH_LANES][BATCH_MAX_LENGTH + 1];
+    static unsigned char columns[BATCH_MAX_LENGTH * BATCH_LANES];
+    char query[BATCH_MAX_LENGTH + 1];
+    CuAssertIntEquals(test, 1, levenshteinBatchKernelSupported(BATCH_KERNEL_SCALAR));
+    for (int kernel = 0; kernel < BATCH_NUM_KERNELS; kernel++)
+    {
+        if (!levenshteinBatchKernelSupported(kernel))
+        {
+            printf("%s kernel not supported, skipped\n", levenshteinBatchKernelNameOf(kernel));
+            continue;
+        }
+        srand(266);
+        for (int round = 0; round < 200; round++)
+        {
+            // Mostly short words, some as long as the kernel allows
+            int maxLength = round % 20 == 0 ? BATCH_MAX_LENGTH : 20;
+            int length = rand() % (maxLength + 1);
+            for (int lane = 0; lane < BATCH_LANES; lane++)
+            {
+                randomWord(words[lane], length);
+                for (int j = 0; j < length; j++)
+                {
+                    columns[j * BATCH_LANES + lane] = (unsigned char) words[lane][j];
+                }
+            }
+            randomWord(query, rand() % (maxLength + 1));
+            unsigned short distances[BATCH_LANES];
+            levenshteinBatchWithKernel(kernel, query, (int) strlen(query), columns, length,
+                                       distances);
+            for (int lane = 0; lane < BATCH_LANES; lane++)
+            {
+                CuAssertIntEquals(test, computeLevenshtein(query, words[lane]), distances[lane]);
+            }
+        }
+    }
+}
+
+/**
+ * Tests the batch search against a full DP over the same random words: the
+ * suggestion distances must match the smallest distances.
+ * @param test
+ */
+void testSuggestionCache(CuTest* test)
+{
+    printf("\n--- Testing suggestion cache ---\n");
+    SuggestionCache* cache = suggestionCacheNew(3, 2);
+    Suggestion found[2] = { { "cat", 1, 0 }, { "cot", 1, 0 } };
+    Suggestion out[2];
+    CuAssertIntEquals(test, -1, suggestionCacheGet(cache, "cst", out, 2));
+    suggestionCachePut(cache, "cst", found, 2);
+    suggestionCachePut(cache, "dgo", found, 1);
+    suggestionCachePut(cache, "xyz", found, 0);
+
+    // Lookups ignore case
+    CuAssertIntEquals(test, 2, suggestionCacheGet(cache, "CsT", out, 2));
+    CuAssertStrEquals(test, "cat", out[0].word);
+    CuAssertStrEquals(test, "cot", out[1].word);
+    CuAssertIntEquals(test, 1, suggestionCacheGet(cache, "cst", out, 1));
+    CuAssertIntEquals(test, 0, suggestionCacheGet(cache, "xyz", out, 2));
+
+    // "dgo" is now the least recently used and makes room
+    suggestionCachePut(cache, "new", found, 2);
+    CuAssertIntEquals(test, -1, suggestionCacheGet(cache, "dgo", out, 2));
+    CuAssertIntEquals(test, 2, suggestionCacheGet(cache, "new", out, 2));
+    CuAssertIntEquals(test, 2, suggestionCacheGet(cache, "cst", out, 2));
+    CuAssertIntEquals(test, 3, cache->size);
+    CuAssertIntEquals(test, 5, cache->hits);
+    CuAssertIntEquals(test, 2, cache->misses);
+
+    // Churn through many more words than fit
+    char word[16];
+    for (int i = 0; i < 100; i++)
+    {
+        sprintf(word, "w%d", i);
+        suggestionCachePut(cache, word, found, i % 3);
+        CuAssertIntEquals(test, i % 3 < 2 ? i % 3 : 2, suggestionCacheGet(cache, word, out, 2));
+    }
+    CuAssertIntEquals(test, 3, cache->size);
+    CuAssertIntEquals(test, 3, hashMapSize(cache->map));
+
+    suggestionCacheClear(cache);
+    CuAssertIntEquals(test, -1, suggestionCacheGet(cache, "w99", out, 2));
+    CuAssertIntEquals(test, 0, cache->size);
+    suggestionCacheDelete(cache);
+}
+
+void testSuggestionStore(CuTest* test)
+{
+    printf("\n--- Testing suggestion store ---\n");
+    const char* fileName = "tests.store";
+    remove(fileName);
+    Suggestion found[2] = { { "cat", 1, 7 }, { "cot", 2, 0 } };
+    Suggestion out[2];
+    SuggestionStore* store = suggestionStoreOpen(fileName, 1);
+    CuAssertPtrNotNull(test, store);
+    CuAssertIntEquals(test, 0, store->loaded);
+    suggestionStoreAppend(store, "CST", found, 2, 2);
+    suggestionStoreAppend(store, "xyz", found, 0, 2);
+    suggestionStoreAppend(store, "dgo", found, 1, 1);
+    CuAssertIntEquals(test, 3, store->appended);
+    // Appended records are only read by the next opening
+    CuAssertIntEquals(test, -1, suggestionStoreGet(store, "cst", out, 2));
+    suggestionStoreClose(store);
+
+    // Cut a record short, as a crash in the middle of a write would
+    FILE* file = fopen(fileName, "ab");
+    StoreRecord torn = { STORE_RECORD_MARKER, 100, 0 };
+    fwrite(&torn, sizeof(torn), 1, file);
+    // Include starts of the marker, which is "1GUS" on little-endian hosts,
+    // that resyncing has to pass over
+    fputs("a1Gc1GU", file);
+    fclose(file);
+    store = suggestionStoreOpen(fileName, 1);
+    suggestionStoreAppend(store, "new", found, 1, 2);
+    suggestionStoreClose(store);
+
+    store = suggestionStoreOpen(fileName, 1);
+    CuAssertIntEquals(test, 4, store->loaded);
+    CuAssertIntEquals(test, 2, suggestionStoreGet(store, "cst", out, 2));
+    CuAssertStrEquals(test, "cat", out[0].word);
+    CuAssertIntEquals(test, 1, out[0].distance);
+    CuAssertIntEquals(test, 7, out[0].frequency);
+    CuAssertStrEquals(test, "cot", out[1].word);
+    CuAssertIntEquals(test, 0, suggestionStoreGet(store, "xyz", out, 2));
+    CuAssertIntEquals(test, 1, suggestionStoreGet(store, "new", out, 2));
+    // "dgo" was stored when only one suggestion was asked for
+    CuAssertIntEquals(test, 1, suggestionStoreGet(store, "dgo", out, 1));
+    CuAssertIntEquals(test, -1, suggestionStoreGet(store, "dgo", out, 2));
+    CuAssertIntEquals(test, -1, suggestionStoreGet(store, "cat", out, 2));
+    CuAssertIntEquals(test, 4, store->hits);
+    suggestionStoreClose(store);
+
+    // A different dictionary empties the store
+    store = suggestionStoreOpen(fileName, 2);
+    CuAssertPtrNotNull(test, store);
+    CuAssertIntEquals(test, 0, store->loaded);
+    CuAssertIntEquals(test, -1, suggestionStoreGet(store, "cst", out, 2));
+    suggestionStoreClose(store);
+    remove(fileName);
+}
+
+void testBatchSearch(CuTest* test)
+{
+    printf("\n--- Testing batch edit distance (%s kernel) ---\n", levenshteinBatchKernelName());
+    int numWords = 500;
+    char* words[500];
+    srand(262);
+    for (int i = 0; i < numWords; i++)
+    {
+        words[i] = malloc(21);
+        randomWord(words[i], 1 + rand() % 20);
+    }
+    WordBatch* batch = wordBatchNew((const char**) words, NULL, numWords);
+    SearchPool* pool = searchPoolNew(batch, 3);
+    CuAssertPtrNotNull(test, pool);
+
+    char query[21];
+    for (int q = 0; q < 50; q++)
+    {
+        randomWord(query, rand() % 21);
+        // Count how many words are at each distance
+        int counts[42] = { 0 };
+        for (int i = 0; i < numWords; i++)
+        {
+            counts[computeLevenshtein(query, words[i])]++;
+        }
+        Suggestion suggestions[5];
+        CuAssertIntEquals(test, 5, wordBatchSearch(batch, query, suggestions, 5, METRIC_LEVENSHTEIN));
+        int distance = 0;
+        for (int s = 0; s < 5; s++)
+        {
+            while (counts[distance] == 0)
+            {
+                distance++;
+            }
+            CuAssertIntEquals(test, distance, suggestions[s].distance);
+            CuAssertIntEquals(test, distance, computeLevenshtein(query, suggestions[s].word));
+            counts[distance]--;
+        }
+        // Searching in parallel finds the same words in the same order
+        Suggestion parallel[5];
+        CuAssertIntEquals(test, 5, searchPoolSearch(pool, query, parallel, 5, METRIC_LEVENSHTEIN));
+        for (int s = 0; s < 5; s++)
+        {
+            CuAssertStrEquals(test, suggestions[s].word, parallel[s].word);
+        }
+    }
+
+    searchPoolDelete(pool);
+    wordBatchDelete(batch);
+    for (int i = 0; i < numWords; i++)
+    {
+        free(words[i]);
+    }
+}
+
+// --- Queue tests ---
+
+#define QUEUE_THREADS 3
+#define QUEUE_ITEMS 20000
+
+/**
+ * Pushes the numbers 1 to QUEUE_ITEMS, as pointers, onto the queue.
+ * @param queue
+ * @return NULL.
+ */
+void* queueProducer(void* queue)
+{
+    for (long i = 1; i <= QUEUE_ITEMS; i++)
+    {
+        ringQueuePush(queue, (void*) i);
+    }
+    return NULL;
+}
+
+/**
+ * Pops numbers off the queue until it pops 0, and returns their sum.
+ * @param queue
+ * @return The sum, as a pointer.
+ */
+void* queueConsumer(void* queue)
+{
+    long sum = 0;
+    long item;
+    while ((item = (long) ringQueuePop(queue)) != 0)
+    {
+        sum += item;
+    }
+    return (void*) sum;
+}
+
+/**
+ * Tests the queue alone and then with several producers and consumers
+ * sharing a small ring: every item pushed must be popped exactly once.
+ * @param test
+ */
+void testRingQueue(CuTest* test)
+{
+    printf("\n--- Testing lock-free queue ---\n");
+    RingQueue* queue = ringQueueNew(3);
+    void* item;
+    CuAssertIntEquals(test, 0, ringQueueTryPop(queue, &item));
+    for (long i = 0; i < 4; i++)
+    {
+        CuAssertIntEquals(test, 1, ringQueueTryPush(queue, (void*) i));
+    }
+    CuAssertIntEquals(test, 0, ringQueueTryPush(queue, NULL));
+    for (long i = 0; i < 4; i++)
+    {
+        CuAssertIntEquals(test, 1, ringQueueTryPop(queue, &item));
+        CuAssertTrue(test, item == (void*) i);
+    }
+    CuAssertIntEquals(test, 0, ringQueueTryPop(queue, &item));
+    ringQueueDelete(queue);
+
+    queue = ringQueueNew(8);
+    pthread_t producers[QUEUE_THREADS];
+    pthread_t consumers[QUEUE_THREADS];
+    for (int i = 0; i < QUEUE_THREADS; i++)
+    {
+        pthread_create(&producers[i], NULL, queueProducer, queue);
+        pthread_create(&consumers[i], NULL, queueConsumer, queue);
+    }
+    for (int i = 0; i < QUEUE_THREADS; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    for (int i = 0; i < QUEUE_THREADS; i++)
+    {
+        ringQueuePush(queue, NULL);
+    }
+    long total = 0;
+    for (int i = 0; i < QUEUE_THREADS; i++)
+    {
+        void* sum;
+        pthread_join(consumers[i], &sum);
+        total += (long) sum;
+    }
+    CuAssertTrue(test, total == (long) QUEUE_THREADS * QUEUE_ITEMS * (QUEUE_ITEMS + 1) / 2);
+    ringQueueDelete(queue);
+}
+
+// --- Concurrent map tests ---
+
+#define COUNT_THREADS 4
+#define COUNT_KEYS 5000
+
+/**
+ * Adds 1 to every one of the keys "0" to COUNT_KEYS - 1, starting at a
+ * different key in each thread so that inserts and resizes overlap.
+ * @param map
+ * @return NULL.
+ */
+void* countKeys(void* map)
+{
+    static int nextStart = 0;
+    int start = __atomic_fetch_add(&nextStart, COUNT_KEYS / COUNT_THREADS, __ATOMIC_RELAXED);
+    char key[16];
+    for (int i = 0; i < COUNT_KEYS; i++)
+    {
+        sprintf(key, "%d", (start + i) % COUNT_KEYS);
+        concurrentHashMapAdd(map, key, 1);
+    }
+    return NULL;
+}
+
+/**
+ * Tests the concurrent map alone and then with several threads counting the
+ * same keys at once: no increment may be lost.
+ * @param test
+ */
+void testConcurrentHashMap(CuTest* test)
+{
+    printf("\n--- Testing concurrent hash map ---\n");
+    ConcurrentHashMap* map = concurrentHashMapNew(16);
+    int value;
+    CuAssertIntEquals(test, 0, concurrentHashMapGet(map, "a", &value));
+    CuAssertIntEquals(test, 3, concurrentHashMapAdd(map, "a", 3));
+    CuAssertIntEquals(test, 5, concurrentHashMapAdd(map, "a", 2));
+    concurrentHashMapPut(map, "b", 7);
+    CuAssertIntEquals(test, 1, concurrentHashMapGet(map, "b", &value));
+    CuAssertIntEquals(test, 7, value);
+    concurrentHashMapRemove(map, "a");
+    CuAssertIntEquals(test, 0, concurrentHashMapGet(map, "a", &value));
+    CuAssertIntEquals(test, 1, concurrentHashMapSize(map));
+    concurrentHashMapDelete(map);
+
+    map = concurrentHashMapNew(16);
+    pthread_t threads[COUNT_THREADS];
+    for (int i = 0; i < COUNT_THREADS; i++)
+    {
+        pthread_create(&threads[i], NULL, countKeys, map);
+    }
+    for (int i = 0; i < COUNT_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    CuAssertIntEquals(test, COUNT_KEYS, concurrentHashMapSize(map));
+    ConcurrentHashMapIterator iterator;
+    concurrentHashMapIteratorInit(&iterator, map);
+    const char* key;
+    int visited = 0;
+    while (concurrentHashMapIteratorNext(&iterator, &key, &value))
+    {
+        CuAssertIntEquals(test, COUNT_THREADS, value);
+        visited++;
+    }
+    CuAssertIntEquals(test, COUNT_KEYS, visited);
+    concurrentHashMapDelete(map);
+}
+
 // --- Test Suite ---
 
 void addAllTests(CuSuite* suite)
@@ -349,6 +1655,25 @@ void addAllTests(CuSuite* suite)
     SUITE_ADD_TEST(suite, testMultipleUnder);
     SUITE_ADD_TEST(suite, testMultipleOver);
     SUITE_ADD_TEST(suite, testValueUpdate);
+    SUITE_ADD_TEST(suite, testGetOrInsert);
+    SUITE_ADD_TEST(suite, testIncrementalResize);
+    SUITE_ADD_TEST(suite, testReserve);
+    SUITE_ADD_TEST(suite, testLoadFactors);
+    SUITE_ADD_TEST(suite, testHashFunctions);
+    SUITE_ADD_TEST(suite, testArena);
+    SUITE_ADD_TEST(suite, testSnapshot);
+    SUITE_ADD_TEST(suite, testWordCountRanking);
+    SUITE_ADD_TEST(suite, testLevenshteinBounded);
+    SUITE_ADD_TEST(suite, testEditMetrics);
+    SUITE_ADD_TEST(suite, testWordTrie);
+    SUITE_ADD_TEST(suite, testTopK);
+    SUITE_ADD_TEST(suite, testFrequencyRanking);
+    SUITE_ADD_TEST(suite, testSuggestionCache);
+    SUITE_ADD_TEST(suite, testSuggestionStore);
+    SUITE_ADD_TEST(suite, testBatchKernels);
+    SUITE_ADD_TEST(suite, testBatchSearch);
+    SUITE_ADD_TEST(suite, testRingQueue);
+    SUITE_ADD_TEST(suite, testConcurrentHashMap);
 }
 
 int main()
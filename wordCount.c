@@ -0,0 +1,157 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "wordCount.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Copies every word and count out of the map.
+ * @param map
+ * @return Allocated array of hashMapSize(map) entries.
+ */
+WordCount *extractCounts(HashMap *map) {
+    WordCount *entries = malloc(sizeof(WordCount) * (hashMapSize(map) > 0 ? hashMapSize(map) : 1));
+    HashMapIterator iterator;
+    hashMapIteratorInit(&iterator, map);
+    const char *key;
+    int *value;
+    int i = 0;
+    while (hashMapIteratorNext(&iterator, &key, &value)) {
+        entries[i].word = key;
+        entries[i].count = *value;
+        i++;
+    }
+    return entries;
+}
+
+/**
+ * Returns 1 if the first entry ranks after the second: a lower count, or the
+ * same count and a later word.
+ * @param a
+ * @param b
+ * @return 1 if a ranks after b.
+ */
+static int ranksAfter(const WordCount *a, const WordCount *b) {
+    return a->count != b->count ? a->count < b->count : strcmp(a->word, b->word) > 0;
+}
+
+/**
+ * Orders entries alphabetically by word, for qsort.
+ * @param a
+ * @param b
+ * @return Comparison result.
+ */
+static int compareWords(const void *a, const void *b) {
+    return strcmp(((const WordCount *) a)->word, ((const WordCount *) b)->word);
+}
+
+/**
+ * Moves the entry at the given index down a heap whose root is the entry
+ * that ranks last.
+ * @param heap
+ * @param size
+ * @param index
+ */
+static void siftDown(WordCount *heap, int size, int index) {
+    WordCount entry = heap[index];
+    while (2 * index + 1 < size) {
+        int child = 2 * index + 1;
+        if (child + 1 < size && ranksAfter(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!ranksAfter(&heap[child], &entry)) {
+            break;
+        }
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = entry;
+}
+
+/**
+ * Moves the n most frequent entries to the front of the array, most frequent
+ * first, with ties broken alphabetically. Only a heap of n entries is kept
+ * ordered, so this costs O(size log n) rather than a full sort.
+ * @param entries
+ * @param size
+ * @param n
+ * @return Number of entries selected, at most n.
+ */
+int selectTopCounts(WordCount *entries, int size, int n) {
+    if (n > size) {
+        n = size;
+    }
+    if (n <= 0) {
+        return 0;
+    }
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        siftDown(entries, n, i);
+    }
+    for (int i = n; i < size; i++) {
+        if (ranksAfter(&entries[0], &entries[i])) {
+            entries[0] = entries[i];
+            siftDown(entries, n, 0);
+        }
+    }
+    // Heap sort the selection, taking the last-ranked entry off the root
+    for (int end = n - 1; end > 0; end--) {
+        WordCount last = entries[0];
+        entries[0] = entries[end];
+        entries[end] = last;
+        siftDown(entries, end, 0);
+    }
+    return n;
+}
+
+/**
+ * Sorts the entries by count, highest first, with an LSD radix sort over the
+ * bytes of the count, then sorts each run of equal counts alphabetically, so
+ * ties rank as in selectTopCounts. Passes over bytes that are the same in
+ * every count are skipped, so small counts take one or two passes.
+ * @param entries
+ * @param size
+ */
+void radixSortCounts(WordCount *entries, int size) {
+    WordCount *buffer = malloc(sizeof(WordCount) * (size > 0 ? size : 1));
+    WordCount *from = entries;
+    WordCount *to = buffer;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int histogram[256] = { 0 };
+        for (int i = 0; i < size; i++) {
+            // Inverting the count sorts it high to low
+            histogram[(~(unsigned int) from[i].count >> shift) & 0xff]++;
+        }
+        if (size == 0 || histogram[(~(unsigned int) from[0].count >> shift) & 0xff] == size) {
+            continue;
+        }
+        int position = 0;
+        for (int b = 0; b < 256; b++) {
+            int count = histogram[b];
+            histogram[b] = position;
+            position += count;
+        }
+        for (int i = 0; i < size; i++) {
+            to[histogram[(~(unsigned int) from[i].count >> shift) & 0xff]++] = from[i];
+        }
+        WordCount *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != entries) {
+        memcpy(entries, from, sizeof(WordCount) * size);
+    }
+    free(buffer);
+    for (int start = 0; start < size;) {
+        int end = start + 1;
+        while (end < size && entries[end].count == entries[start].count) {
+            end++;
+        }
+        if (end - start > 1) {
+            qsort(entries + start, end - start, sizeof(WordCount), compareWords);
+        }
+        start = end;
+    }
+}
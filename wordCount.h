@@ -0,0 +1,31 @@
+#ifndef WORD_COUNT_H
+#define WORD_COUNT_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "hashMap.h"
+
+/*
+ * Ranking of the concordance's word counts for the sorted and top-N
+ * listings. Both rank words by count, highest first, and words with the same
+ * count alphabetically, so the top N of the sorted listing are the top-N
+ * listing whatever order the map held the words in.
+ */
+
+typedef struct WordCount WordCount;
+
+// A word and its count, extracted from the map for sorting.
+struct WordCount
+{
+    const char* word;
+    int count;
+};
+
+WordCount* extractCounts(HashMap* map);
+int selectTopCounts(WordCount* entries, int size, int n);
+void radixSortCounts(WordCount* entries, int size);
+
+#endif
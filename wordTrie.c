@@ -0,0 +1,234 @@
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "wordTrie.h"
+#include "levenshtein.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+typedef struct TrieWord TrieWord;
+
+// A word being sorted into the trie.
+struct TrieWord {
+    const char *word;
+    int frequency;
+};
+
+static int compareWords(const void *a, const void *b) {
+    return strcmp(((const TrieWord *) a)->word, ((const TrieWord *) b)->word);
+}
+
+/**
+ * Appends a node with no children, doubling the node array when it is full.
+ * @param trie
+ * @param character
+ * @return Index of the node.
+ */
+static int trieNodeNew(WordTrie *trie, char character) {
+    assert(trie->capacity > 0);
+    if (trie->numNodes == trie->capacity) {
+        trie->capacity *= 2;
+        trie->nodes = realloc(trie->nodes, sizeof(TrieNode) * trie->capacity);
+    }
+    TrieNode *node = &trie->nodes[trie->numNodes];
+    node->end = -1;
+    node->word = -1;
+    node->character = character;
+    return trie->numNodes++;
+}
+
+/**
+ * Builds the trie over the given words. The words are sorted first, so each
+ * one only adds the nodes past the prefix it shares with the word before
+ * it, and nodes come out in depth-first order. The trie keeps pointers to
+ * the words, which must outlive it. Repeated words are kept once.
+ * @param words
+ * @param frequencies How common each word is, used to rank words at equal
+ * distance, or NULL if they are all equally common.
+ * @param numWords
+ * @return The allocated trie.
+ */
+WordTrie *wordTrieNew(const char **words, const int *frequencies, int numWords) {
+    TrieWord *sorted = malloc(sizeof(TrieWord) * (numWords > 0 ? numWords : 1));
+    int maxLength = 0;
+    for (int i = 0; i < numWords; i++) {
+        sorted[i].word = words[i];
+        sorted[i].frequency = frequencies != NULL ? frequencies[i] : 0;
+        int length = (int) strlen(words[i]);
+        if (length > maxLength) {
+            maxLength = length;
+        }
+    }
+    qsort(sorted, numWords, sizeof(TrieWord), compareWords);
+
+    WordTrie *trie = malloc(sizeof(WordTrie));
+    trie->capacity = numWords + 1;
+    trie->nodes = malloc(sizeof(TrieNode) * trie->capacity);
+    trie->numNodes = 0;
+    trie->words = malloc(sizeof(char *) * (numWords > 0 ? numWords : 1));
+    trie->frequencies = malloc(sizeof(int) * (numWords > 0 ? numWords : 1));
+    trie->numWords = 0;
+    trie->maxLength = maxLength;
+    trie->stopDistance = -1;
+    trie->stopFrequency = 0;
+
+    // Nodes along the path of the previous word, the root first
+    int *path = malloc(sizeof(int) * (maxLength + 1));
+    path[0] = trieNodeNew(trie, '\0');
+    int depth = 0;
+    const char *previous = "";
+    for (int i = 0; i < numWords; i++) {
+        const char *word = sorted[i].word;
+        int common = 0;
+        while (word[common] != '\0' && word[common] == previous[common]) {
+            common++;
+        }
+        // The previous word's nodes past the shared prefix are complete
+        while (depth > common) {
+            trie->nodes[path[depth--]].end = trie->numNodes;
+        }
+        for (; word[depth] != '\0'; depth++) {
+            path[depth + 1] = trieNodeNew(trie, word[depth]);
+        }
+        TrieNode *last = &trie->nodes[path[depth]];
+        if (last->word < 0) {
+            last->word = trie->numWords;
+            trie->words[trie->numWords] = word;
+            trie->frequencies[trie->numWords++] = sorted[i].frequency;
+        }
+        previous = word;
+    }
+    while (depth >= 0) {
+        trie->nodes[path[depth--]].end = trie->numNodes;
+    }
+    free(path);
+    free(sorted);
+    return trie;
+}
+
+/**
+ * Frees the trie. The words are not freed.
+ * @param trie
+ */
+void wordTrieDelete(WordTrie *trie) {
+    assert(trie != NULL);
+    free(trie->nodes);
+    free(trie->words);
+    free(trie->frequencies);
+    free(trie);
+}
+
+/**
+ * Makes searches stop as soon as they have found numSuggestions words, each
+ * within stopDistance of the query and with a frequency of at least
+ * stopFrequency (see topKSetStop).
+ * @param trie
+ * @param stopDistance -1 to always search the whole trie.
+ * @param stopFrequency
+ */
+void wordTrieSetEarlyStop(WordTrie *trie, int stopDistance, int stopFrequency) {
+    assert(trie != NULL);
+    trie->stopDistance = stopDistance;
+    trie->stopFrequency = stopFrequency;
+}
+
+/**
+ * Returns 1 if the word is in the trie and 0 otherwise.
+ * @param trie
+ * @param word
+ * @return 1 if the word is found, 0 otherwise.
+ */
+int wordTrieContains(WordTrie *trie, const char *word) {
+    assert(trie != NULL);
+    assert(word != NULL);
+    int node = 0;
+    for (; *word != '\0'; word++) {
+        int child = node + 1;
+        // Siblings are sorted, so the search can end at a larger character
+        while (child < trie->nodes[node].end &&
+               (unsigned char) trie->nodes[child].character < (unsigned char) *word) {
+            child = trie->nodes[child].end;
+        }
+        if (child == trie->nodes[node].end || trie->nodes[child].character != *word) {
+            return 0;
+        }
+        node = child;
+    }
+    return trie->nodes[node].word >= 0;
+}
+
+/**
+ * Finds the words closest to the query under the given metric. The walk
+ * fills one DP row per node from its parent's row and skips a node's
+ * subtree once no word in it can rank among the suggestions: with the
+ * smallest distance in the node's row past the farthest suggestion, the
+ * rows below only grow. A swap reaches back two rows, so for the metrics
+ * with swaps the row before must be out of reach as well.
+ * @param trie
+ * @param query
+ * @param suggestions Filled with the closest words, nearest first.
+ * @param numSuggestions Number of words wanted.
+ * @param metric Distance to rank the words by, one of the METRIC_ constants.
+ * @return Number of suggestions found, less than numSuggestions only if the
+ * trie has fewer words.
+ */
+int wordTrieSearch(WordTrie *trie, const char *query, Suggestion *suggestions, int numSuggestions,
+                   int metric) {
+    assert(trie != NULL);
+    assert(query != NULL);
+    assert(numSuggestions > 0);
+    TopK topK;
+    topKInit(&topK, suggestions, numSuggestions);
+    topKSetStop(&topK, trie->stopDistance, trie->stopFrequency);
+
+    int queryLength = (int) strlen(query);
+    int width = queryLength + 1;
+    int *rows = malloc(sizeof(int) * width * (trie->maxLength + 1));
+    int *rowMins = malloc(sizeof(int) * (trie->maxLength + 1));
+    // Character and subtree end of the node at each depth of the current path
+    char *path = malloc(trie->maxLength + 1);
+    int *ends = malloc(sizeof(int) * (trie->maxLength + 1));
+    int indel = editDistanceLengthCost(metric);
+    for (int y = 0; y <= queryLength; y++) {
+        rows[y] = y * indel;
+    }
+    rowMins[0] = 0;
+    ends[0] = trie->nodes[0].end;
+    if (trie->nodes[0].word >= 0) {
+        topKOffer(&topK, trie->words[0], rows[queryLength], trie->frequencies[0]);
+    }
+
+    int depth = 0;
+    int i = 1;
+    while (i < trie->numNodes && !topKDone(&topK)) {
+        // Climb back to the node's parent
+        while (i >= ends[depth]) {
+            depth--;
+        }
+        depth++;
+        TrieNode *node = &trie->nodes[i];
+        path[depth] = node->character;
+        ends[depth] = node->end;
+        int *row = rows + depth * width;
+        rowMins[depth] = editDistanceRow(metric, query, queryLength, depth, node->character,
+                                         path[depth - 1], row - width,
+                                         depth > 1 ? row - 2 * width : NULL, row);
+        int bound = topKBound(&topK);
+        if (node->word >= 0 && row[queryLength] <= bound) {
+            topKOffer(&topK, trie->words[node->word], row[queryLength],
+                      trie->frequencies[node->word]);
+            bound = topKBound(&topK);
+        }
+        int reachable = rowMins[depth] <= bound ||
+                        (metric != METRIC_LEVENSHTEIN && rowMins[depth - 1] + indel <= bound);
+        i = reachable ? i + 1 : node->end;
+    }
+    free(rows);
+    free(rowMins);
+    free(path);
+    free(ends);
+    return topKFinish(&topK);
+}
@@ -0,0 +1,61 @@
+#ifndef WORD_TRIE_H
+#define WORD_TRIE_H
+
+/*
+ * CS 261 Data Structures
+ * Assignment 5
+ */
+
+#include "suggestion.h"
+
+/*
+ * Trie over a fixed set of words, built once from all of them. Nodes are
+ * stored in depth-first order, so the first child of a node directly
+ * follows it and a whole subtree can be skipped by jumping to its end.
+ * Siblings are in character order.
+ *
+ * A search walks the trie depth first and keeps one DP row per depth (see
+ * editDistanceRow). Words sharing a prefix share the rows for it, and a
+ * subtree is skipped once its rows show that no word in it can come within
+ * reach.
+ */
+
+typedef struct TrieNode TrieNode;
+typedef struct WordTrie WordTrie;
+
+struct TrieNode
+{
+    // Index of the first node after this node's subtree.
+    int end;
+    // Index of the word ending at this node, or -1 if none does.
+    int word;
+    // Last character of the prefix the node stands for; 0 at the root.
+    char character;
+};
+
+struct WordTrie
+{
+    // Nodes in depth-first order, the root first.
+    TrieNode* nodes;
+    int numNodes;
+    int capacity;
+    // Distinct words in sorted order, not owned by the trie, and how common
+    // each one is.
+    const char** words;
+    int* frequencies;
+    int numWords;
+    // Length of the longest word.
+    int maxLength;
+    // Searches stop early as set by wordTrieSetEarlyStop, never by default.
+    int stopDistance;
+    int stopFrequency;
+};
+
+WordTrie* wordTrieNew(const char** words, const int* frequencies, int numWords);
+void wordTrieDelete(WordTrie* trie);
+void wordTrieSetEarlyStop(WordTrie* trie, int stopDistance, int stopFrequency);
+int wordTrieContains(WordTrie* trie, const char* word);
+int wordTrieSearch(WordTrie* trie, const char* query, Suggestion* suggestions, int numSuggestions,
+                   int metric);
+
+#endif